@@ -4,7 +4,18 @@
 
 #include <sdsl/lcp_bitcompressed.hpp>
 #include <sdsl/rmq_succinct_sada.hpp>
+#include <atomic>
+#include <cstring>
+#include <functional>
+#include <future>
+#include <memory>
+#include <thread>
+#include <unordered_map>
+#ifdef _OPENMP
+#include <omp.h>
+#endif
 #include "SelfGrammarIndex.h"
+#include "utils/ws_deque.h"
 
 #define _MAX_PROOF 1000
 
@@ -38,20 +49,86 @@ void SelfGrammarIndex::load(std::fstream &fin) {
 
     _g.load(fin);
     grid.load(fin);
+    clear_query_structures();
+
+
+}
+
+void SelfGrammarIndex::load_components(const component_files & files, const bool & parallel, const bool & lazy_tries) {
+
+    std::vector<std::future<void>> tasks;
+    auto component = [&tasks,&parallel](const std::string & file, std::function<void(std::fstream&)> load){
+        if(file.empty())
+            return;
+        tasks.push_back(std::async(parallel ? std::launch::async : std::launch::deferred,[file,load](){
+            std::fstream f(file,std::ios::in|std::ios::binary);
+            load(f);
+        }));
+    };
+
+    component(files.rules_pt,[this](std::fstream& f){ load_rules_pt(f); });
+    component(files.sfx_pt,[this](std::fstream& f){ load_sfx_pt(f); });
+
+    component(files.X_p,[this](std::fstream& f){ _g.load_X_p(f); });
+    component(files.z,[this](std::fstream& f){ _g.load_z(f); });
+    component(files.F,[this](std::fstream& f){ _g.load_F(f); });
+    component(files.tree,[this](std::fstream& f){ _g.load_mtree(f); });
+    component(files.L,[this](std::fstream& f){ _g.load_l(f); });
+    component(files.y,[this](std::fstream& f){ _g.load_y(f); });
+    component(files.alp,[this](std::fstream& f){ _g.load_alp(f); });
+    if(lazy_tries && !files.left_trie.empty())
+        _g.defer_tries(files.left_trie,files.right_trie);
+    else{
+        component(files.left_trie,[this](std::fstream& f){ _g.load_ltrie(f); });
+        component(files.right_trie,[this](std::fstream& f){ _g.load_rtrie(f); });
+    }
+
+    component(files.SL,[this](std::fstream& f){ grid.load_SL(f); });
+    component(files.SB,[this](std::fstream& f){ grid.load_SB(f); });
+    component(files.XB,[this](std::fstream& f){ grid.load_XB(f); });
+    component(files.XA,[this](std::fstream& f){ grid.load_XA(f); });
+    /*
+     * The weights of count are optional, indexes built before them do not have the file
+     * */
+    component(files.count,[this](std::fstream& f){ if(f.is_open()) grid.load_SW(f); });
+
+    /*
+     * get() runs the deferred tasks of the serial load and rethrows the exception of a
+     * component that failed
+     * */
+    for (auto &&t : tasks)
+        t.get();
 
+    clear_query_structures();
+}
+
+void SelfGrammarIndex::clear_query_structures() {
 
+    prefix_cache.clear();
+    suffix_cache.clear();
+    build_rule_qgrams(0);
+    heavy = heavy_occ();
+    build_fingerprints(0);
+    build_display_samples(0);
+    short_rules.clear();
 }
 
 bool SelfGrammarIndex::expand_prefix(const grammar_representation::g_long & X, std::string & s, const size_t & l,size_t & pos )const
 {
     const auto& Tg = _g.get_parser_tree();
 
-    std::deque<std::pair<uint,std::pair<uint,uint>>> Q;
+    if(short_rules.length(X) > 0)
+    {
+        short_expand(X,s,l,pos,false);
+        return true;
+    }
 
-    uint node  = Tg[_g.select_occ(X,1)];
+    std::deque<std::pair<size_t,std::pair<size_t,size_t>>> Q;
 
-    uint current_leaf = Tg.leafrank(node);
-    uint last_leaf = current_leaf+Tg.leafnum(node)-1;
+    size_t node  = Tg[_g.select_occ(X,1)];
+
+    size_t current_leaf = Tg.leafrank(node);
+    size_t last_leaf = current_leaf+Tg.leafnum(node)-1;
     //Q.emplace_front(node,std::make_pair(current_leaf,last_leaf));
     while(current_leaf <= last_leaf)
     {
@@ -69,6 +146,16 @@ bool SelfGrammarIndex::expand_prefix(const grammar_representation::g_long & X, s
                 Q.pop_front();
             }
         }
+        else if(short_rules.length(X_i) > 0)
+        {
+            if(short_expand(X_i,s,l,pos,false)) return true;
+            current_leaf++;
+            while(current_leaf > last_leaf && !Q.empty()){
+                current_leaf = Q.front().second.first+1;
+                last_leaf = Q.front().second.second;
+                Q.pop_front();
+            }
+        }
         else
         {
             //Save actua state;
@@ -86,11 +173,17 @@ bool SelfGrammarIndex::expand_suffix(const grammar_representation::g_long  &X_i,
 {
     const auto& Tg = _g.get_parser_tree();
 
-    std::deque<std::pair<uint,std::pair<uint,uint>>> Q;
+    if(short_rules.length(X_i) > 0)
+    {
+        short_expand(X_i,s,l,pos,true);
+        return true;
+    }
+
+    std::deque<std::pair<size_t,std::pair<size_t,size_t>>> Q;
 
-    uint node  = Tg[_g.select_occ(X_i,1)];
+    size_t node  = Tg[_g.select_occ(X_i,1)];
 
-    uint first_leaf = Tg.leafrank(node);
+    size_t first_leaf = Tg.leafrank(node);
 
     long int  current_leaf= first_leaf+Tg.leafnum(node)-1;
 
@@ -116,6 +209,18 @@ bool SelfGrammarIndex::expand_suffix(const grammar_representation::g_long  &X_i,
                 Q.pop_front();
             }
         }
+        else if(short_rules.length(X) > 0)
+        {
+            if(short_expand(X,s,l,pos,true))
+                return true;
+            --current_leaf;
+
+            while(current_leaf < first_leaf && !Q.empty()){
+                current_leaf = Q.front().second.first-1;
+                first_leaf = Q.front().second.second;
+                Q.pop_front();
+            }
+        }
         else
         {
             //Save actua state;
@@ -171,14 +276,28 @@ void SelfGrammarIndex::expand_grammar_sfx(const size_t & sfx, std::string & s, c
 
     s[pos] = '\0';
 }
-void SelfGrammarIndex::find_second_occ(long int & offset, unsigned int & node, std::vector<uint> & occ) const{
-;
+void SelfGrammarIndex::find_second_occ(long int & offset, size_t & node, std::vector<index_long> & occ) const{
+
     const auto& Tg = _g.get_parser_tree();
-    std::deque<std::pair< uint, long int >> S;
+    /*
+     * Frontier of occurrences (preorder of the node, offset), the same order of a FIFO queue
+     * */
+    std::vector<std::pair< size_t, long int >> S, next;
+
+    auto report = [&occ](const index_long & pos)->bool{
+        occ.push_back(pos);
+        return true;
+    };
 
     {
         size_t pre = Tg.pre_order(node);
         size_t Xi = _g[pre];
+        uint64_t k;
+        if(heavy.find(Xi,k))
+        {
+            heavy.report(k,offset,report);
+            return;
+        }
         size_t n_s_occ = _g.n_occ(Xi);
         for (size_t i = 1; i <= n_s_occ; ++i)
         {
@@ -187,40 +306,338 @@ void SelfGrammarIndex::find_second_occ(long int & offset, unsigned int & node, s
         }
     }
 
-    ////uint steps = 0;
+    /*
+     * The frontier is expanded in groups of G occurrences and in stages, every stage runs
+     * for the whole group and prefetches what the next one reads, so the dependent
+     * accesses of an occurrence overlap with the ones of the rest of the group
+     * */
+    const size_t G = 16;
+    size_t g_node[G], g_parent[G], g_X[G];
+
     while(!S.empty())
     {
-        ///std::pair<size_t , long int > front_pair = S.front();
+        next.clear();
+
+        for (size_t b = 0; b < S.size(); b += G)
+        {
+            size_t e = std::min(b + G, S.size());
+            /*
+             * Nodes of the occurrences and their parents, prefetching their offsets in L
+             * */
+            for (size_t j = b; j < e; ++j)
+            {
+                if(S[j].first == 1) continue;
+                g_node[j-b] = Tg[S[j].first];
+                g_parent[j-b] = Tg.parent(g_node[j-b]);
+                _g.prefetch_offset(g_node[j-b]);
+                _g.prefetch_offset(g_parent[j-b]);
+            }
+            /*
+             * Rules of the parents, prefetching their first occurrence
+             * */
+            for (size_t j = b; j < e; ++j)
+            {
+                if(S[j].first == 1) continue;
+                g_X[j-b] = _g[Tg.pre_order(g_parent[j-b])];
+                _g.prefetch_first_occ(g_X[j-b]);
+            }
+            /*
+             * Offsets of the parents and their occurrences
+             * */
+            for (size_t j = b; j < e; ++j)
+            {
+                if(S[j].first == 1)
+                {
+                    occ.push_back((index_long)(S[j].second));
+                    continue;
+                }
+                size_t Xi = g_X[j-b];
+                long int p_offset = S[j].second + _g.offsetText(g_node[j-b]) - _g.offsetText(g_parent[j-b]);
+                uint64_t k;
+                if(heavy.find(Xi,k))
+                {
+                    heavy.report(k,p_offset,report);
+                    continue;
+                }
+                size_t n_s_occ = _g.n_occ(Xi);
+                for (size_t i = 1; i <= n_s_occ; ++i)
+                    next.emplace_back(_g.select_occ(Xi, i),p_offset);
+            }
+        }
+
+        S.swap(next);
+    }
+
+}
 
+void SelfGrammarIndex::find_second_occ_dag(index_long r1, index_long r2, index_long c1, index_long c2, long len, std::vector<index_long> & occ) const {
+    query_context ctx;
+    find_second_occ_dag(r1,r2,c1,c2,len,occ,ctx);
+}
+
+void SelfGrammarIndex::find_second_occ_dag(index_long r1, index_long r2, index_long c1, index_long c2, long len, std::vector<index_long> & occ, query_context & ctx) const {
+
+    const auto& Tg = _g.get_parser_tree();
+
+    auto& pairs = ctx.pairs;
+    grid.range2(r1,r2,c1,c2,pairs,ctx.grid_buffers);
+
+    if(pairs.size() < 2)
+    {
+        for (auto &pair : pairs) {
+            size_t p = grid.first_label_col(pair.second);
+            size_t parent = Tg.parent(Tg[p]);
+            long l = long(- len + _g.offsetText(Tg[p])) - _g.offsetText(parent);
+            find_second_occ(l,parent,[&occ](const index_long & pos)->bool{ occ.push_back(pos); return true; },ctx.frames);
+        }
+        return;
+    }
+
+    /*
+     * The rules of the query are the entries [0,n_dag) of ctx.dag (dag_id maps a rule to its entry),
+     * the entries are reused among the calls so their vectors keep their capacity. dag_queue keeps
+     * the entries in the order they are found, a rule is expanded when the head of the queue reaches it
+     * */
+    auto& id = ctx.dag_id;
+    auto& rules = ctx.dag;
+    auto& S = ctx.dag_queue;
+    auto& ready = ctx.ready;
+    id.clear();
+    S.clear();
+    ready.clear();
+    ctx.n_dag = 0;
+
+    /*
+     * Entry of the rule X, a new one if X is not in the query
+     * */
+    auto entry = [&](const size_t & X)->size_t{
+        flat_map::value_type e = ctx.n_dag;
+        if(id.emplace(X,e))
+        {
+            if(rules.size() == e)
+                rules.emplace_back();
+            auto& R = rules[e];
+            R.X = X;
+            R.off.clear();
+            R.up.clear();
+            R.pending = 0;
+            R.root = R.heavy = false;
+            R.k = 0;
+            ++ctx.n_dag;
+            S.push_back(e);
+        }
+        return (size_t)e;
+    };
+
+    for (auto &pair : pairs) {
+        size_t p = grid.first_label_col(pair.second);
+        size_t parent = Tg.parent(Tg[p]);
+        long l = long(- len + _g.offsetText(Tg[p])) - _g.offsetText(parent);
+        size_t Xi = _g[Tg.pre_order(parent)];
+        rules[entry(Xi)].off.push_back(l);
+    }
+
+    /*
+     * Collecting the ancestors of the rules of the primary occurrences (S grows while it is read)
+     * */
+    for (size_t h = 0; h < S.size(); ++h)
+    {
+        size_t e = S[h];
+        size_t Xi = rules[e].X;
+        /*
+         * The positions of the heavy rules are materialized, no need to go up
+         * */
+        if(heavy.find(Xi,rules[e].k))
+        {
+            rules[e].heavy = true;
+            continue;
+        }
+        size_t n_s_occ = _g.n_occ(Xi);
+        for (size_t i = 1; i <= n_s_occ; ++i)
+        {
+            size_t pre_occ = _g.select_occ(Xi,i);
+            if(pre_occ == 1)
+            {
+                rules[e].root = true;
+                continue;
+            }
+            auto _node = Tg[pre_occ];
+            size_t parent = Tg.parent(_node);
+            size_t Xp = _g[Tg.pre_order(parent)];
+            // entry may grow rules, the references to its entries are not kept
+            size_t ep = entry(Xp);
+            rules[e].up.emplace_back(ep,(long)_g.offsetText(_node) - (long)_g.offsetText(parent));
+            ++rules[ep].pending;
+        }
+    }
+
+    for (size_t e = 0; e < ctx.n_dag; ++e)
+        if(rules[e].pending == 0)
+            ready.push_back(e);
+
+    /*
+     * Pushing the offsets of each rule to the rules where it occurs
+     * */
+    while(!ready.empty())
+    {
+        size_t e = ready.back();
+        ready.pop_back();
+        auto& R = rules[e];
+
+        if(R.root)
+            for (auto &&o : R.off)
+                occ.push_back((index_long)o);
+
+        if(R.heavy)
+            for (auto &&o : R.off)
+                heavy.report(R.k,o,[&occ](const index_long & pos)->bool{ occ.push_back(pos); return true; });
+
+        for (auto &&u : R.up)
+        {
+            auto& P = rules[u.first];
+            for (auto &&o : R.off)
+                P.off.push_back(o + u.second);
+            if(--P.pending == 0)
+                ready.push_back(u.first);
+        }
+
+        R.off.clear();
+    }
+}
+
+void SelfGrammarIndex::find_second_occ_plain(index_long r1, index_long r2, index_long c1, index_long c2, long len, std::vector<index_long> & occ) const {
+
+    const auto& Tg = _g.get_parser_tree();
+
+    std::vector< std::pair<size_t,size_t> > pairs;
+    grid.range2(r1,r2,c1,c2,pairs);
+
+    std::deque<std::pair< size_t, long int >> S;
+    for (auto &pair : pairs) {
+        size_t p = grid.first_label_col(pair.second);
+        size_t parent = Tg.parent(Tg[p]);
+        long int offset = long (- len + _g.offsetText(Tg[p])) - _g.offsetText(parent);
+        size_t Xi = _g[Tg.pre_order(parent)];
+        size_t n_s_occ = _g.n_occ(Xi);
+        for (size_t i = 1; i <= n_s_occ; ++i)
+            S.emplace_back(_g.select_occ(Xi,i),offset);
+    }
+
+    while(!S.empty())
+    {
         if(S.front().first == 1)
         {
-            occ.push_back((uint)(S.front().second));
+            occ.push_back((index_long)(S.front().second));
         }
         else
         {
             auto _node = Tg[S.front().first];
             size_t parent = Tg.parent(_node);
-            size_t pre_parent = Tg.pre_order(parent);
-            size_t Xi = _g[pre_parent];
+            size_t Xi = _g[Tg.pre_order(parent)];
             size_t n_s_occ = _g.n_occ(Xi);
             long int p_offset = S.front().second + _g.offsetText(_node) - _g.offsetText(parent);
             for (size_t i = 1; i <= n_s_occ; ++i)
+                S.emplace_back(_g.select_occ(Xi, i),p_offset);
+        }
+        S.pop_front();
+    }
+}
+
+void SelfGrammarIndex::find_second_occ_par(index_long r1, index_long r2, index_long c1, index_long c2, long len, std::vector<index_long> & occ) const {
+
+#ifndef _OPENMP
+    find_second_occ(r1,r2,c1,c2,len,occ);
+#else
+    /*
+     * No nested parallel regions, the caller already keeps the threads busy
+     * */
+    if(omp_in_parallel())
+    {
+        find_second_occ(r1,r2,c1,c2,len,occ);
+        return;
+    }
+
+    const auto& Tg = _g.get_parser_tree();
+
+    std::vector< std::pair<size_t,size_t> > pairs;
+    grid.range2(r1,r2,c1,c2,pairs);
+    if(pairs.empty()) return;
+
+    /*
+     * Every thread owns a lock-free deque of pairs (preorder of a node, offset of the occurrence
+     * in the node) and an output buffer. The owner works on the bottom of its deque and the idle
+     * threads steal from the top of the others' deques (see ws_deque).
+     * */
+    size_t n_threads = omp_get_max_threads();
+    std::vector< std::unique_ptr<ws_deque> > Q(n_threads);
+    for (auto &&q : Q)
+        q.reset(new ws_deque(2*pairs.size()/n_threads + 64));
+    std::vector< std::vector<index_long> > t_occ(n_threads);
+    std::atomic<size_t> pending(pairs.size());
+
+    /*
+     * Seeding the queues with the nodes of the primary occurrences, the pattern starts
+     * len symbols before the node of the first label of the column
+     * */
+    for (size_t k = 0; k < pairs.size(); ++k) {
+        size_t p = grid.first_label_col(pairs[k].second);
+        Q[k % n_threads]->push(ws_deque::item(p, -len));
+    }
+
+#pragma omp parallel num_threads(n_threads)
+    {
+        size_t id = omp_get_thread_num();
+        ws_deque::item item;
+
+        while(pending.load() > 0)
+        {
+            bool has_item = Q[id]->pop(item);
+            for (size_t k = 1; !has_item && k < n_threads; ++k)
+                has_item = Q[(id + k) % n_threads]->steal(item);
+            if(!has_item)
             {
-                size_t i_pre_parent;
-                i_pre_parent = _g.select_occ(Xi, i);
-                S.emplace_back(i_pre_parent,p_offset);
+                std::this_thread::yield();
+                continue;
             }
-        }
 
-        S.pop_front();
+            if(item.first == 1)
+            {
+                t_occ[id].push_back((index_long)(item.second));
+            }
+            else
+            {
+                auto _node = Tg[item.first];
+                size_t parent = Tg.parent(_node);
+                size_t pre_parent = Tg.pre_order(parent);
+                size_t Xi = _g[pre_parent];
+                size_t n_s_occ = _g.n_occ(Xi);
+                long int p_offset = item.second + _g.offsetText(_node) - _g.offsetText(parent);
+
+                uint64_t k;
+                if(heavy.find(Xi,k))
+                {
+                    auto& out = t_occ[id];
+                    heavy.report(k,p_offset,[&out](const index_long & pos)->bool{ out.push_back(pos); return true; });
+                    n_s_occ = 0;
+                }
+
+                pending += n_s_occ;
+                for (size_t i = 1; i <= n_s_occ; ++i)
+                    Q[id]->push(ws_deque::item(_g.select_occ(Xi, i),p_offset));
+            }
+            --pending;
+        }
     }
 
+    for (auto &&  o : t_occ)
+        occ.insert(occ.end(),o.begin(),o.end());
+#endif
 }
 
-void SelfGrammarIndex::find_second_occ(long int & offset, unsigned int & node, sdsl::bit_vector & occ) const{
+void SelfGrammarIndex::find_second_occ(long int & offset, size_t & node, sdsl::bit_vector & occ) const{
 
     const auto& Tg = _g.get_parser_tree();
-    std::deque<std::pair< uint, long int >> S;
+    std::deque<std::pair< size_t, long int >> S;
 
     {
         size_t pre = Tg.pre_order(node);
@@ -262,18 +679,51 @@ void SelfGrammarIndex::find_second_occ(long int & offset, unsigned int & node, s
 
 }
 
-void SelfGrammarIndex::display(const std::size_t & i, const std::size_t & j, std::string & str) {
+void SelfGrammarIndex::display(const std::size_t & i, const std::size_t & j, std::string & str) const {
+    query_context ctx;
+    display(i,j,str,ctx);
+}
 
-    const auto& Tg = _g.get_parser_tree();
-    long long int p = i;
+void SelfGrammarIndex::display(const std::size_t & i, const std::size_t & j, std::string & str, query_context & ctx) const {
+    ctx.descent.clear();
+    display_descent(i,j,str,ctx);
+}
 
-    std::stack<std::pair<size_t ,size_t >> s_path;
-    dfuds::dfuds_tree::dfuds_long root = Tg.root();
+void SelfGrammarIndex::display_descent(const std::size_t & i, const std::size_t & j, std::string & str, query_context & ctx) const {
 
-    s_path.push(make_pair(0,Tg.leafnum(root)+1));
-    // auto start = timer::now();
+    const auto& Tg = _g.get_parser_tree();
+    size_t n = _g.get_size_text();
+    size_t n_leaves = Tg.leafnum(Tg.root());
+    /*
+     * Last position of the leaf l
+     * */
+    auto leaf_end = [this,&n,&n_leaves](const size_t & l)->size_t{
+        return (l == n_leaves)? n - 1 : _g.select_L(l + 1) - 1;
+    };
 
-    auto current_node = root;
+    /*
+     * Keeping the levels of the previous descent whose node covers [i,j]
+     * */
+    auto& D = ctx.descent;
+    while(!D.empty())
+    {
+        size_t lr = Tg.leafrank(D.back().node);
+        if(_g.select_L(lr) + D.back().shift <= i && j <= leaf_end(lr + Tg.leafnum(D.back().node) - 1) + D.back().shift)
+            break;
+        D.pop_back();
+    }
+    if(D.empty())
+    {
+        /*
+         * Starting from the sampled node of the block of i if it covers [i,j] (the root otherwise)
+         * */
+        size_t jump_node_i, shift;
+        jump_start(i,j,jump_node_i,shift);
+        D.push_back(descent_level{jump_node_i,shift,{0,Tg.leafrank(jump_node_i) + Tg.leafnum(jump_node_i)}});
+    }
+
+    auto current_node = D.back().node;
+    long long int p = (long long int)(i - D.back().shift);
     bool notend = true;
 
     while(notend)
@@ -305,13 +755,18 @@ void SelfGrammarIndex::display(const std::size_t & i, const std::size_t & j, std
             size_t l2_r = Tg.leafrank(current_node);
 
             p += (long long int)_g.select_L(l2_r);
-            s_path.push(make_pair(l,l2_r + Tg.leafnum(current_node)));
+            D.push_back(descent_level{current_node,i - (size_t)p,{l,l2_r + Tg.leafnum(current_node)}});
         }
 
 
 
     }
 
+    auto& s_path = ctx.path;
+    s_path.clear();
+    for (auto &&d : D)
+        s_path.push_back(d.leaves);
+
     auto off = (long long int)(j-i+1);
     str.resize(off);
     size_t pos = 0;
@@ -320,13 +775,13 @@ void SelfGrammarIndex::display(const std::size_t & i, const std::size_t & j, std
 
     while(!s_path.empty() && pos < off  ){
 
-        if(current_leaf == s_path.top().second )
+        if(current_leaf == s_path.back().second )
         {
-            if(s_path.top().first == 0)
+            if(s_path.back().first == 0)
                 break;
 
-            current_leaf = s_path.top().first+1;
-            s_path.pop();
+            current_leaf = s_path.back().first+1;
+            s_path.pop_back();
         }else{
             expand_prefix(_g[Tg.pre_order(Tg.leafselect(current_leaf))],str,(size_t)off,pos);
             ++current_leaf;
@@ -335,6 +790,197 @@ void SelfGrammarIndex::display(const std::size_t & i, const std::size_t & j, std
 
 }
 
+void SelfGrammarIndex::expand_interval_lz(const std::pair<size_t, size_t> & range, std::string & s, std::size_t & pos, query_context & ctx) const {
+
+    const auto& Tg = _g.get_parser_tree();
+    size_t n = _g.get_size_text();
+    size_t n_leaves = Tg.leafnum(Tg.root());
+
+    /*
+     * Leaf of the position p and last position of the leaf l
+     * */
+    auto leaf = [this](const size_t & p)->size_t{
+        return _g.rank_L(p) + _g.L[p];
+    };
+    auto leaf_end = [this,&n,&n_leaves](const size_t & l)->size_t{
+        return (l == n_leaves)? n - 1 : _g.select_L(l + 1) - 1;
+    };
+
+    auto& S = ctx.expand;
+    auto& done = ctx.expanded;
+    S.clear();
+    done.clear();
+    S.push_back(expand_frame{leaf(range.first),leaf(range.second),range.first,range.second,0,pos});
+
+    while(!S.empty())
+    {
+        auto& f = S.back();
+        if(f.t > f.last)
+        {
+            if(f.X != 0)
+            {
+                flat_map::value_type out = f.out;
+                done.emplace(f.X,out);
+            }
+            S.pop_back();
+            continue;
+        }
+
+        size_t t = f.t++;
+        size_t st = _g.select_L(t), en = leaf_end(t);
+        size_t lo = std::max(f.a,st), hi = std::min(f.b,en);
+        auto X = _g[Tg.pre_order(Tg.leafselect(t))];
+
+        if(_g.isTerminal(X))
+        {
+            s[pos++] = _g.terminal_simbol(X);
+            continue;
+        }
+        /*
+         * Copying the symbols of X from its previous expansion
+         * */
+        flat_map::value_type out;
+        if(done.find(X,out))
+        {
+            std::memcpy(&s[pos],&s[out + lo - st],hi - lo + 1);
+            pos += hi - lo + 1;
+            continue;
+        }
+        if(short_rules.length(X) > 0)
+        {
+            std::memcpy(&s[pos],short_rules.data(X) + lo - st,hi - lo + 1);
+            pos += hi - lo + 1;
+            continue;
+        }
+        /*
+         * Going to the first occurrence of X
+         * */
+        auto node_def = Tg[_g.select_occ(X,1)];
+        size_t p = _g.select_L(Tg.leafrank(node_def));
+        size_t a = p + lo - st, b = p + hi - st;
+        bool complete = (lo == st && hi == en);
+        S.push_back(expand_frame{leaf(a),leaf(b),a,b,complete? (size_t)X : 0,pos});
+    }
+}
+
+void SelfGrammarIndex::display_batch(const std::vector<std::pair<size_t,size_t>> & intervals, std::vector<std::string> & out, query_context & ctx, const size_t & gap) const {
+
+    out.clear();
+    out.resize(intervals.size());
+
+    std::vector<size_t> order(intervals.size());
+    for (size_t k = 0; k < order.size(); ++k) order[k] = k;
+    std::sort(order.begin(),order.end(),[&intervals](const size_t & a, const size_t & b)->bool{
+        return intervals[a] < intervals[b];
+    });
+
+    std::string span;
+    ctx.descent.clear();
+    size_t k = 0;
+    while(k < order.size())
+    {
+        /*
+         * Group of intervals covered by [i,j]
+         * */
+        size_t i = intervals[order[k]].first, j = intervals[order[k]].second;
+        size_t e = k + 1;
+        while(e < order.size() && intervals[order[e]].first <= j + gap + 1)
+        {
+            j = std::max(j,intervals[order[e]].second);
+            ++e;
+        }
+
+        display_descent(i,j,span,ctx);
+        for (; k < e; ++k)
+        {
+            const auto& r = intervals[order[k]];
+            out[order[k]] = span.substr(r.first - i,r.second - r.first + 1);
+        }
+    }
+}
+
+SelfGrammarIndex::text_reader::text_reader(const SelfGrammarIndex & _idx, const std::size_t & i, const std::size_t & j):idx(&_idx),left(j - i + 1)
+{
+    const auto& _g = idx->_g;
+    const auto& Tg = _g.get_parser_tree();
+    long long int p = i;
+
+    /*
+     * Same descent of display, every level keeps the leaves of its definition after
+     * the one it goes down into
+     * */
+    auto current_node = Tg.root();
+    bool notend = true;
+
+    while(notend)
+    {
+        dfuds::dfuds_tree::dfuds_long ls = Tg.leafrank(current_node);
+        dfuds::dfuds_tree::dfuds_long hs = ls + Tg.leafnum(current_node)-1;
+        dfuds::dfuds_tree::dfuds_long  l = Tg.find_child(current_node,ls,hs,[&p,&notend,&_g](const dfuds::dfuds_tree::dfuds_long &child)->bool{
+            size_t pos_m = _g.select_L(child);
+            if(pos_m == p)  notend = false;
+            return p < pos_m;
+        });
+
+        if(!notend)
+        {
+            /* the leaf l starts at p */
+            S.emplace_back(l,hs+1);
+            break;
+        }
+
+        S.emplace_back(l+1,hs+1);
+        current_node = Tg.leafselect(l);
+        auto X_j = _g[Tg.pre_order(current_node)];
+        p -= (long long int)_g.select_L(l);
+        current_node = Tg[_g.select_occ(X_j,1)];
+        p += (long long int)_g.select_L(Tg.leafrank(current_node));
+    }
+}
+
+size_t SelfGrammarIndex::text_reader::read(char * buf, const size_t & n)
+{
+    const auto& _g = idx->_g;
+    const auto& Tg = _g.get_parser_tree();
+    size_t r = 0;
+    while(r < n && left > 0 && !S.empty())
+    {
+        if(S.back().first == S.back().second)
+        {
+            S.pop_back();
+            continue;
+        }
+        size_t leaf = S.back().first++;
+        auto X = _g[Tg.pre_order(Tg.leafselect(leaf))];
+        if(_g.isTerminal(X))
+        {
+            buf[r++] = (char)_g.terminal_simbol(X);
+            --left;
+        }
+        else
+        {
+            /* going down into the definition of X */
+            auto node_def = Tg[_g.select_occ(X,1)];
+            size_t lr = Tg.leafrank(node_def);
+            S.emplace_back(lr,lr + Tg.leafnum(node_def));
+        }
+    }
+    return r;
+}
+
+void SelfGrammarIndex::extract(const std::size_t & i, const std::size_t & j, std::ostream & out, const size_t & chunk) const
+{
+    std::vector<char> buf(chunk);
+    text_reader reader(*this,i,j);
+    while(!reader.eof())
+    {
+        size_t r = reader.read(buf.data(),chunk);
+        if(r == 0)
+            break;
+        out.write(buf.data(),r);
+    }
+}
+
 void SelfGrammarIndex::display_trie(const std::size_t & i , const std::size_t & j, std::string & str) {
 
     const auto& Tg = _g.get_parser_tree();
@@ -419,19 +1065,23 @@ void SelfGrammarIndex::display_trie(const std::size_t & i , const std::size_t &
 
 size_t SelfGrammarIndex::size_in_bytes() const {
 //    std::cout<<"SelfGrammarIndex::size_in_bytes()\n";
-    return _g.size_in_bytes() + grid.size_in_bytes();
+    return _g.size_in_bytes() + grid.size_in_bytes() + sdsl::size_in_bytes(rule_pfx_q) + sdsl::size_in_bytes(rule_sfx_q) + heavy.size_in_bytes() + fingerprints.size_in_bytes() +
+           sdsl::size_in_bytes(jump_node) + sdsl::size_in_bytes(jump_shift) + sdsl::size_in_bytes(jump_end) + short_rules.size_in_bytes();
 }
 
 int SelfGrammarIndex::cmp_prefix(const compressed_grammar::g_long & X_i, std::string::iterator & itera, std::string::iterator & end) const{
 
     const auto& Tg = _g.get_parser_tree();
 
-    std::deque<std::pair<uint,std::pair<uint,uint>>> Q;
+    if(short_rules.length(X_i) > 0)
+        return short_cmp_prefix(X_i,itera,end);
 
-    uint node  = Tg[_g.select_occ(X_i,1)];
+    std::deque<std::pair<size_t,std::pair<size_t,size_t>>> Q;
 
-    uint current_leaf = Tg.leafrank(node);
-    uint last_leaf = current_leaf+Tg.leafnum(node)-1;
+    size_t node  = Tg[_g.select_occ(X_i,1)];
+
+    size_t current_leaf = Tg.leafrank(node);
+    size_t last_leaf = current_leaf+Tg.leafnum(node)-1;
 
     //Q.emplace_front(node,std::make_pair(current_leaf,last_leaf));
 
@@ -456,6 +1106,19 @@ int SelfGrammarIndex::cmp_prefix(const compressed_grammar::g_long & X_i, std::st
                 Q.pop_front();
             }
         }
+        else if(short_rules.length(X) > 0)
+        {
+            int r = short_cmp_prefix(X,itera,end);
+            if(r != 0 || itera == end) return r;
+            current_leaf++;
+
+            while(current_leaf > last_leaf && !Q.empty())
+            {
+                current_leaf = Q.front().second.first+1;
+                last_leaf = Q.front().second.second;
+                Q.pop_front();
+            }
+        }
         else
         {
             //Save actua state;
@@ -470,7 +1133,7 @@ int SelfGrammarIndex::cmp_prefix(const compressed_grammar::g_long & X_i, std::st
 
 }
 
-int SelfGrammarIndex::cmp_suffix_grammar(const size_t & sfx, std::string::iterator & iterator1, std::string::iterator & iterator2)
+int SelfGrammarIndex::cmp_suffix_grammar(const size_t & sfx, std::string::iterator & iterator1, std::string::iterator & iterator2) const
 {
 
     if(iterator1 == iterator2)
@@ -514,14 +1177,17 @@ int SelfGrammarIndex::cmp_suffix(const compressed_grammar::g_long & X_i, std::st
 
 
 
+    if(short_rules.length(X_i) > 0)
+        return short_cmp_suffix(X_i,itera,end);
+
     const auto& Tg = _g.get_parser_tree();
 
-    std::deque<std::pair<uint,std::pair<uint,uint>>> Q;
+    std::deque<std::pair<size_t,std::pair<size_t,size_t>>> Q;
 
-    uint node  = Tg[_g.select_occ(X_i,1)];
+    size_t node  = Tg[_g.select_occ(X_i,1)];
 
-    uint current_leaf = Tg.leafrank(node);
-    uint last_leaf = current_leaf+Tg.leafnum(node)-1;
+    size_t current_leaf = Tg.leafrank(node);
+    size_t last_leaf = current_leaf+Tg.leafnum(node)-1;
     swap(current_leaf,last_leaf);
 
     //Q.emplace_front(node,std::make_pair(current_leaf,last_leaf));
@@ -546,6 +1212,17 @@ int SelfGrammarIndex::cmp_suffix(const compressed_grammar::g_long & X_i, std::st
             }
 
         }
+        else if(short_rules.length(X) > 0)
+        {
+            int r = short_cmp_suffix(X,itera,end);
+            if(r != 0 || itera == end-1) return r;
+            --current_leaf;
+            while(current_leaf < last_leaf && !Q.empty()){
+                current_leaf = Q.front().second.first-1;
+                last_leaf = Q.front().second.second;
+                Q.pop_front();
+            }
+        }
         else
         {
             //Save actua state;
@@ -573,6 +1250,9 @@ bool SelfGrammarIndex::bp_expand_prefix(const compressed_grammar::g_long &X_i,st
 
     }
 
+    if(short_rules.length(X_i) > 0)
+        return short_expand(X_i,s,l,pos,false);
+
 
     const auto& Tg = _g.get_parser_tree();
     const auto& tree = _g.get_left_trie();
@@ -620,138 +1300,618 @@ bool SelfGrammarIndex::bp_expand_prefix(const compressed_grammar::g_long &X_i,st
     }
 
 
-    while(depht_node_xi > 0)
+    while(depht_node_xi > 0)
+    {
+        auto ancestor_l_1  = bp_rep.levelancestor(node_xi_left_path,depht_node_xi-1);
+
+        size_t  preoreder_trie = bp_rep.pre_order(ancestor_l_1);
+        size_t  X = seq[preoreder_trie-1];
+        size_t  preorder_parser_tree = _g.select_occ(X,1);
+
+        size_t  u = Tg[preorder_parser_tree];
+
+
+
+        size_t l_rp = Tg.leafrank(u);
+        size_t n_limit = l_rp + Tg.leafnum(u)-1;
+
+        size_t v = Tg.fchild(u);
+        size_t lnum_s_ch = Tg.leafnum(v);
+
+        for(size_t i = l_rp + lnum_s_ch; i <= n_limit; ++i)
+        {
+            size_t leaf_t = Tg.leafselect(i);
+
+            if( bp_expand_prefix(_g[Tg.pre_order(leaf_t)],s,l,pos) )
+            {
+                return true;
+            }
+        }
+
+
+
+        /*size_t  n_ch = Tg.children(u);
+
+        ///size_t  begin = (top == current)?1:2;
+        for (size_t  i = 2 ; i <= n_ch ; ++i) {
+            size_t  ch = Tg.child(u,i);
+
+            if( bp_expand_prefix(_g[Tg.pre_order(ch)],s,l,pos) )
+            {
+                return true;
+            }
+        }*/
+
+        --depht_node_xi;
+    }
+
+    return false;
+}
+
+bool SelfGrammarIndex::bp_expand_suffix(const compressed_grammar::g_long &X_i,std::string & s, const size_t & l,size_t & pos) const
+{
+//    assert(X_i > 0 && X_i < _g.n_rules());
+
+    if(_g.isTerminal(X_i))
+    {
+        unsigned char a_th = _g.terminal_simbol(X_i); // a_th symbol in the sorted alphabet
+        s[pos]= a_th;
+        return l == ++pos;
+
+    }
+
+    if(short_rules.length(X_i) > 0)
+        return short_expand(X_i,s,l,pos,true);
+
+    const auto& Tg = _g.get_parser_tree();
+    const auto& tree = _g.get_right_trie();
+    const auto& bp_rep = tree.get_tree();
+    const auto& seq = tree.get_seq();
+    const auto& inv_seq = tree.get_seq_inv();
+    /*
+    * Find the left most path for X_i in left_trie
+    *
+    * */
+
+    /*
+     * Finding the preorder of the node with tag X_i in left most path trie
+     * */
+    size_t  pre_tlmp_xi = inv_seq[X_i] + 1;
+    /*
+     * Finding the node with preorder pre_tlmp_xi in left most path trie
+     * */
+    size_t  node_xi_left_path = bp_rep[pre_tlmp_xi];
+
+    /*
+     * Finding child of the root that is ancestor of node_xi_left_path
+     * */
+
+    int depht_node_xi = (int)bp_rep.depth(node_xi_left_path);
+    --depht_node_xi;
+    auto current  = bp_rep.levelancestor(node_xi_left_path,--depht_node_xi);
+    /*
+     * root's child ancestor
+     * */
+
+    size_t  X_a = seq[bp_rep.pre_order(current)-1];
+
+    if(_g.isTerminal(X_a)){
+
+        unsigned char a_th = _g.terminal_simbol(X_a); // a_th symbol in the sorted alphabet
+        s[pos]= a_th;
+
+        if(l == ++pos)
+            return true;
+    }
+
+
+    while(depht_node_xi > 0)
+    {
+        auto ancestor_l_1  = bp_rep.levelancestor(node_xi_left_path,depht_node_xi-1);
+        size_t  preoreder_trie = bp_rep.pre_order(ancestor_l_1);
+        size_t  X = seq[preoreder_trie-1];
+        size_t  preorder_parser_tree = _g.select_occ(X,1);
+
+        size_t  u = Tg[preorder_parser_tree];
+        size_t  n_ch = Tg.children(u);
+
+        ///size_t  begin = (top == current)?1:2;
+        for (size_t  i = n_ch-1 ; i > 0 ; --i) {
+            size_t  ch = Tg.child(u,i);
+
+            if( bp_expand_suffix(_g[Tg.pre_order(ch)],s,l,pos) )
+            {
+                return true;
+            }
+        }
+
+        --depht_node_xi;
+    }
+
+
+    return false;
+
+}
+
+int
+SelfGrammarIndex::bp_cmp_prefix(const compressed_grammar::g_long & X_i, std::string::iterator & itera, std::string::iterator & end) const {
+    int r;
+    if(short_rules.length(X_i) > 0)
+        return short_cmp_prefix(X_i,itera,end);
+    if(qgram_cmp_prefix(X_i,itera,end,r))
+        return r;
+    if(fp_cmp_prefix(X_i,itera,end,r))
+        return r;
+    if(cached_cmp_prefix(X_i,itera,end,r))
+        return r;
+    return bp_cmp_prefix_tree(X_i,itera,end);
+}
+
+int
+SelfGrammarIndex::bp_cmp_suffix(const compressed_grammar::g_long & X_i, std::string::iterator & itera, std::string::iterator & end) const {
+    int r;
+    if(short_rules.length(X_i) > 0)
+        return short_cmp_suffix(X_i,itera,end);
+    if(qgram_cmp_suffix(X_i,itera,end,r))
+        return r;
+    if(fp_cmp_suffix(X_i,itera,end,r))
+        return r;
+    if(cached_cmp_suffix(X_i,itera,end,r,true))
+        return r;
+    return bp_cmp_suffix_tree(X_i,itera,end);
+}
+
+uint64_t SelfGrammarIndex::fp_prefix(grammar_representation::g_long X, size_t l) const
+{
+    const auto& Tg = _g.get_parser_tree();
+    uint64_t h = 0;
+    while(l > 0)
+    {
+        if(l == fingerprints.length(X))
+            return fingerprints.concat(h,fingerprints[X],l);
+        /*
+         * l < |X|, adding the children of X before the one that contains the l-th symbol
+         * */
+        auto node = Tg[_g.select_occ(X,1)];
+        size_t n_ch = Tg.children(node);
+        for (size_t i = 1; i <= n_ch; ++i)
+        {
+            size_t Z = _g[Tg.pre_order(Tg.child(node,i))];
+            uint64_t lz = fingerprints.length(Z);
+            if(lz > l)
+            {
+                X = Z;
+                break;
+            }
+            h = fingerprints.concat(h,fingerprints[Z],lz);
+            l -= lz;
+            if(l == 0) break;
+        }
+    }
+    return h;
+}
+
+uint64_t SelfGrammarIndex::fp_suffix(grammar_representation::g_long X, size_t l) const
+{
+    const auto& Tg = _g.get_parser_tree();
+    uint64_t h = 0, lh = 0;
+    while(l > 0)
+    {
+        if(l == fingerprints.length(X))
+            return fingerprints.concat(fingerprints[X],h,lh);
+        /*
+         * l < |X|, adding the children of X after the one that contains the l-th symbol from the right
+         * */
+        auto node = Tg[_g.select_occ(X,1)];
+        size_t n_ch = Tg.children(node);
+        for (size_t i = n_ch; i >= 1; --i)
+        {
+            size_t Z = _g[Tg.pre_order(Tg.child(node,i))];
+            uint64_t lz = fingerprints.length(Z);
+            if(lz > l)
+            {
+                X = Z;
+                break;
+            }
+            h = fingerprints.concat(fingerprints[Z],h,lh);
+            lh += lz;
+            l -= lz;
+            if(l == 0) break;
+        }
+    }
+    return h;
+}
+
+unsigned char SelfGrammarIndex::rule_symbol(grammar_representation::g_long X, size_t l, const bool & reverse) const
+{
+    const auto& Tg = _g.get_parser_tree();
+    while(!_g.isTerminal(X))
+    {
+        auto node = Tg[_g.select_occ(X,1)];
+        size_t n_ch = Tg.children(node);
+        for (size_t k = 1; k <= n_ch; ++k)
+        {
+            size_t i = reverse ? n_ch - k + 1 : k;
+            size_t Z = _g[Tg.pre_order(Tg.child(node,i))];
+            uint64_t lz = fingerprints.length(Z);
+            if(l < lz)
+            {
+                X = Z;
+                break;
+            }
+            l -= lz;
+        }
+    }
+    return _g.terminal_simbol(X);
+}
+
+size_t SelfGrammarIndex::fp_lcp_prefix(const grammar_representation::g_long & X, const std::string::iterator & itera, const size_t & m) const
+{
+    size_t lmax = std::min<size_t>(m,fingerprints.length(X));
+    /*
+     * The first lo symbols match (h_lo is their fingerprint) and the first hi do not
+     * */
+    size_t lo = 0, hi = lmax + 1;
+    uint64_t h_lo = 0;
+    auto pattern_fp = [&](const size_t & l)->uint64_t{
+        uint64_t h = h_lo;
+        for (size_t k = lo; k < l; ++k)
+            h = fingerprints.append(h,(unsigned char)itera[k]);
+        return h;
+    };
+    /*
+     * Exponential search from the beginning (the mismatches are usually close) and binary search
+     * */
+    for (size_t step = 1; lo < lmax; step *= 2)
+    {
+        size_t l = std::min(lo + step,lmax);
+        uint64_t h = pattern_fp(l);
+        if(h != fp_prefix(X,l))
+        {
+            hi = l;
+            break;
+        }
+        lo = l;
+        h_lo = h;
+    }
+    while(hi - lo > 1)
+    {
+        size_t mid = (lo + hi)/2;
+        uint64_t h = pattern_fp(mid);
+        if(h == fp_prefix(X,mid))
+        {
+            lo = mid;
+            h_lo = h;
+        }
+        else
+            hi = mid;
+    }
+    return lo;
+}
+
+size_t SelfGrammarIndex::fp_lcp_suffix(const grammar_representation::g_long & X, const std::string::iterator & itera, const size_t & m) const
+{
+    size_t lmax = std::min<size_t>(m,fingerprints.length(X));
+    /*
+     * The last lo symbols match (h_lo is their fingerprint, pw_lo = B^lo) and the last hi do not
+     * */
+    size_t lo = 0, hi = lmax + 1;
+    uint64_t h_lo = 0, pw_lo = 1;
+    auto pattern_fp = [&](const size_t & l, uint64_t & pw)->uint64_t{
+        uint64_t h = h_lo;
+        pw = pw_lo;
+        for (size_t k = lo; k < l; ++k)
+        {
+            h = fingerprints.prepend(h,(unsigned char)*(itera - k),pw);
+            pw = karp_rabin::mul(pw,fingerprints.base());
+        }
+        return h;
+    };
+    uint64_t pw;
+    for (size_t step = 1; lo < lmax; step *= 2)
+    {
+        size_t l = std::min(lo + step,lmax);
+        uint64_t h = pattern_fp(l,pw);
+        if(h != fp_suffix(X,l))
+        {
+            hi = l;
+            break;
+        }
+        lo = l;
+        h_lo = h;
+        pw_lo = pw;
+    }
+    while(hi - lo > 1)
+    {
+        size_t mid = (lo + hi)/2;
+        uint64_t h = pattern_fp(mid,pw);
+        if(h == fp_suffix(X,mid))
+        {
+            lo = mid;
+            h_lo = h;
+            pw_lo = pw;
+        }
+        else
+            hi = mid;
+    }
+    return lo;
+}
+
+bool SelfGrammarIndex::fp_cmp_prefix(const compressed_grammar::g_long & X_i, std::string::iterator & itera, std::string::iterator & end, int & r) const {
+
+    if(fp_min == 0 || fingerprints.empty() || end - itera < (long)fp_min)
+        return false;
+
+    size_t m = end - itera;
+    size_t l = fp_lcp_prefix(X_i,itera,m);
+    itera += l;
+    if(l == m || l == fingerprints.length(X_i))
+    {
+        r = 0;
+        return true;
+    }
+    unsigned char a = rule_symbol(X_i,l,false);
+    r = (a < (unsigned char)(*itera))? 1 : -1;
+    return true;
+}
+
+bool SelfGrammarIndex::fp_cmp_suffix(const compressed_grammar::g_long & X_i, std::string::iterator & itera, std::string::iterator & end, int & r) const {
+
+    if(fp_min == 0 || fingerprints.empty() || itera - end + 1 < (long)fp_min)
+        return false;
+
+    size_t m = itera - end + 1;
+    size_t l = fp_lcp_suffix(X_i,itera,m);
+    itera -= l;
+    if(l == m || l == fingerprints.length(X_i))
+    {
+        r = 0;
+        return true;
+    }
+    unsigned char a = rule_symbol(X_i,l,true);
+    r = (a < (unsigned char)(*itera))? 1 : -1;
+    return true;
+}
+
+bool SelfGrammarIndex::short_expand(const compressed_grammar::g_long & X, std::string & s, const size_t & l, size_t & pos, const bool & reverse) const {
+
+    size_t len = short_rules.length(X);
+    size_t n = std::min(len, l - pos);
+    const char * src = short_rules.data(X);
+    if(reverse)
     {
-        auto ancestor_l_1  = bp_rep.levelancestor(node_xi_left_path,depht_node_xi-1);
+        for (size_t k = 0; k < n; ++k)
+            s[pos + k] = src[len - 1 - k];
+    }
+    else
+        std::memcpy(&s[pos],src,n);
+    pos += n;
+    return l == pos;
+}
 
-        size_t  preoreder_trie = bp_rep.pre_order(ancestor_l_1);
-        size_t  X = seq[preoreder_trie-1];
-        size_t  preorder_parser_tree = _g.select_occ(X,1);
+int SelfGrammarIndex::short_cmp_prefix(const compressed_grammar::g_long & X, std::string::iterator & itera, std::string::iterator & end) const {
 
-        size_t  u = Tg[preorder_parser_tree];
+    size_t n = std::min((size_t)short_rules.length(X), (size_t)(end - itera));
+    const auto * src = (const unsigned char *)short_rules.data(X);
+    const auto * p = (const unsigned char *)&(*itera);
+    /*
+     * The first mismatch decides the comparison, the rule is < if its symbol is smaller
+     * */
+    if(std::memcmp(src,p,n) != 0)
+    {
+        size_t k = 0;
+        while(src[k] == p[k]) ++k;
+        itera += k;
+        return (src[k] < p[k])? 1 : -1;
+    }
+    itera += n;
+    return 0;
+}
 
+int SelfGrammarIndex::short_cmp_suffix(const compressed_grammar::g_long & X, std::string::iterator & itera, std::string::iterator & end) const {
 
+    size_t len = short_rules.length(X);
+    size_t n = std::min(len, (size_t)(itera - end + 1));
+    const auto * src = (const unsigned char *)short_rules.data(X);
+    for (size_t k = 0; k < n; ++k)
+    {
+        unsigned char a = src[len - 1 - k];
+        if(a < (unsigned char)(*itera)) return 1;
+        if(a > (unsigned char)(*itera)) return -1;
+        --itera;
+    }
+    return 0;
+}
 
-        size_t l_rp = Tg.leafrank(u);
-        size_t n_limit = l_rp + Tg.leafnum(u)-1;
+void SelfGrammarIndex::build_rule_qgrams(const size_t & q)
+{
+    rule_q = (q < 7)? q : 7;
+    if(rule_q == 0)
+    {
+        rule_pfx_q = sdsl::int_vector<>();
+        rule_sfx_q = sdsl::int_vector<>();
+        return;
+    }
 
-        size_t v = Tg.fchild(u);
-        size_t lnum_s_ch = Tg.leafnum(v);
+    size_t n_rules = _g.n_rules();
+    rule_pfx_q = sdsl::int_vector<>(n_rules,0,8*rule_q+4);
+    rule_sfx_q = sdsl::int_vector<>(n_rules,0,8*rule_q+4);
 
-        for(size_t i = l_rp + lnum_s_ch; i <= n_limit; ++i)
-        {
-            size_t leaf_t = Tg.leafselect(i);
+    auto pack = [this](const std::string & s, const size_t & len, const bool & complete)->uint64_t{
+        uint64_t w = 0;
+        for (size_t k = 0; k < len; ++k)
+            w |= ((uint64_t)(unsigned char)s[k]) << (4 + 8*(rule_q-1-k));
+        return w | len | ((uint64_t)complete << 3);
+    };
 
-            if( bp_expand_prefix(_g[Tg.pre_order(leaf_t)],s,l,pos) )
-            {
-                return true;
-            }
-        }
+    std::string s(rule_q,0);
+    for (size_t X = 1; X < n_rules; ++X)
+    {
+        size_t pos = 0;
+        bool complete = !bp_expand_prefix(X,s,rule_q,pos);
+        rule_pfx_q[X] = pack(s,pos,complete);
 
+        pos = 0;
+        complete = !bp_expand_suffix(X,s,rule_q,pos);
+        rule_sfx_q[X] = pack(s,pos,complete);
+    }
+}
 
+bool SelfGrammarIndex::qgram_cmp_prefix(const compressed_grammar::g_long & X_i, std::string::iterator & itera, std::string::iterator & end, int & r) const {
 
-        /*size_t  n_ch = Tg.children(u);
+    if(rule_q == 0 || X_i >= rule_pfx_q.size())
+        return false;
 
-        ///size_t  begin = (top == current)?1:2;
-        for (size_t  i = 2 ; i <= n_ch ; ++i) {
-            size_t  ch = Tg.child(u,i);
+    uint64_t w = rule_pfx_q[X_i];
+    size_t len = w & 7;
+    bool complete = (w >> 3) & 1;
 
-            if( bp_expand_prefix(_g[Tg.pre_order(ch)],s,l,pos) )
-            {
-                return true;
-            }
-        }*/
+    /*
+     * Packing the next len symbols of the pattern
+     * */
+    auto it = itera;
+    uint64_t pw = 0;
+    size_t plen = 0;
+    while(plen < len && it != end)
+    {
+        pw |= ((uint64_t)(unsigned char)(*it)) << (4 + 8*(rule_q-1-plen));
+        ++it;
+        ++plen;
+    }
 
-        --depht_node_xi;
+    uint64_t mask = (plen == 0)? 0 : (((1ULL << (8*plen)) - 1) << (4 + 8*(rule_q-plen)));
+    uint64_t diff = (w ^ pw) & mask;
+    if(diff != 0)
+    {
+        size_t k = rule_q - 1 - ((63 - __builtin_clzll(diff)) - 4)/8;
+        unsigned char a = (w >> (4 + 8*(rule_q-1-k))) & 0xFF;
+        itera += k;
+        r = (a < (unsigned char)(*itera))? 1 : -1;
+        return true;
     }
 
+    if(it == end || (complete && plen == len))
+    {
+        itera = it;
+        r = 0;
+        return true;
+    }
     return false;
 }
 
-bool SelfGrammarIndex::bp_expand_suffix(const compressed_grammar::g_long &X_i,std::string & s, const size_t & l,size_t & pos) const
-{
-//    assert(X_i > 0 && X_i < _g.n_rules());
-
-    if(_g.isTerminal(X_i))
-    {
-        unsigned char a_th = _g.terminal_simbol(X_i); // a_th symbol in the sorted alphabet
-        s[pos]= a_th;
-        return l == ++pos;
-
-    }
+bool SelfGrammarIndex::qgram_cmp_suffix(const compressed_grammar::g_long & X_i, std::string::iterator & itera, std::string::iterator & end, int & r) const {
 
-    const auto& Tg = _g.get_parser_tree();
-    const auto& tree = _g.get_right_trie();
-    const auto& bp_rep = tree.get_tree();
-    const auto& seq = tree.get_seq();
-    const auto& inv_seq = tree.get_seq_inv();
-    /*
-    * Find the left most path for X_i in left_trie
-    *
-    * */
+    if(rule_q == 0 || X_i >= rule_sfx_q.size())
+        return false;
 
-    /*
-     * Finding the preorder of the node with tag X_i in left most path trie
-     * */
-    size_t  pre_tlmp_xi = inv_seq[X_i] + 1;
-    /*
-     * Finding the node with preorder pre_tlmp_xi in left most path trie
-     * */
-    size_t  node_xi_left_path = bp_rep[pre_tlmp_xi];
+    uint64_t w = rule_sfx_q[X_i];
+    size_t len = w & 7;
+    bool complete = (w >> 3) & 1;
 
     /*
-     * Finding child of the root that is ancestor of node_xi_left_path
+     * Packing the previous len symbols of the pattern (backward)
      * */
+    auto it = itera;
+    uint64_t pw = 0;
+    size_t plen = 0;
+    while(plen < len && it != end-1)
+    {
+        pw |= ((uint64_t)(unsigned char)(*it)) << (4 + 8*(rule_q-1-plen));
+        --it;
+        ++plen;
+    }
 
-    int depht_node_xi = (int)bp_rep.depth(node_xi_left_path);
-    --depht_node_xi;
-    auto current  = bp_rep.levelancestor(node_xi_left_path,--depht_node_xi);
-    /*
-     * root's child ancestor
-     * */
+    uint64_t mask = (plen == 0)? 0 : (((1ULL << (8*plen)) - 1) << (4 + 8*(rule_q-plen)));
+    uint64_t diff = (w ^ pw) & mask;
+    if(diff != 0)
+    {
+        size_t k = rule_q - 1 - ((63 - __builtin_clzll(diff)) - 4)/8;
+        unsigned char a = (w >> (4 + 8*(rule_q-1-k))) & 0xFF;
+        itera -= k;
+        r = (a < (unsigned char)(*itera))? 1 : -1;
+        return true;
+    }
 
-    size_t  X_a = seq[bp_rep.pre_order(current)-1];
+    if(it == end-1 || (complete && plen == len))
+    {
+        itera = it;
+        r = 0;
+        return true;
+    }
+    return false;
+}
 
-    if(_g.isTerminal(X_a)){
+bool SelfGrammarIndex::cached_cmp_prefix(const compressed_grammar::g_long & X_i, std::string::iterator & itera, std::string::iterator & end, int & r) const {
 
-        unsigned char a_th = _g.terminal_simbol(X_a); // a_th symbol in the sorted alphabet
-        s[pos]= a_th;
+    if(!prefix_cache.enabled() || _g.isTerminal(X_i))
+        return false;
 
-        if(l == ++pos)
-            return true;
+    rule_cache::entry e;
+    if(!prefix_cache.get(X_i,e))
+    {
+        e.s.resize(prefix_cache.length());
+        size_t pos = 0;
+        e.complete = !bp_expand_prefix(X_i,e.s,e.s.size(),pos);
+        e.s.resize(pos);
+        prefix_cache.put(X_i,e);
     }
 
-
-    while(depht_node_xi > 0)
+    auto it = itera;
+    for (auto &&c : e.s)
     {
-        auto ancestor_l_1  = bp_rep.levelancestor(node_xi_left_path,depht_node_xi-1);
-        size_t  preoreder_trie = bp_rep.pre_order(ancestor_l_1);
-        size_t  X = seq[preoreder_trie-1];
-        size_t  preorder_parser_tree = _g.select_occ(X,1);
+        if((unsigned char)c < (unsigned char)(*it)) { r = 1; itera = it; return true; }
+        if((unsigned char)c > (unsigned char)(*it)) { r = -1; itera = it; return true; }
+        ++it;
+        if(it == end) { r = 0; itera = it; return true; }
+    }
+    if(e.complete)
+    {
+        r = 0;
+        itera = it;
+        return true;
+    }
+    return false;
+}
 
-        size_t  u = Tg[preorder_parser_tree];
-        size_t  n_ch = Tg.children(u);
+bool SelfGrammarIndex::cached_cmp_suffix(const compressed_grammar::g_long & X_i, std::string::iterator & itera, std::string::iterator & end, int & r, const bool & trie) const {
 
-        ///size_t  begin = (top == current)?1:2;
-        for (size_t  i = n_ch-1 ; i > 0 ; --i) {
-            size_t  ch = Tg.child(u,i);
+    if(!suffix_cache.enabled() || _g.isTerminal(X_i))
+        return false;
 
-            if( bp_expand_suffix(_g[Tg.pre_order(ch)],s,l,pos) )
-            {
-                return true;
-            }
+    rule_cache::entry e;
+    if(!suffix_cache.get(X_i,e))
+    {
+        e.s.resize(suffix_cache.length());
+        size_t pos = 0;
+        if(trie)
+            e.complete = !bp_expand_suffix(X_i,e.s,e.s.size(),pos);
+        else{
+            dfs_expand_suffix(X_i,e.s,e.s.size(),pos);
+            e.complete = pos < e.s.size();
         }
-
-        --depht_node_xi;
+        e.s.resize(pos);
+        suffix_cache.put(X_i,e);
     }
 
-
+    auto it = itera;
+    for (auto &&c : e.s)
+    {
+        if((unsigned char)c < (unsigned char)(*it)) { r = 1; itera = it; return true; }
+        if((unsigned char)c > (unsigned char)(*it)) { r = -1; itera = it; return true; }
+        --it;
+        if(it == end-1) { r = 0; itera = it; return true; }
+    }
+    if(e.complete)
+    {
+        r = 0;
+        itera = it;
+        return true;
+    }
     return false;
-
 }
 
 int
-SelfGrammarIndex::bp_cmp_prefix(const compressed_grammar::g_long & X_i, std::string::iterator & itera, std::string::iterator & end) const {
+SelfGrammarIndex::bp_cmp_prefix_tree(const compressed_grammar::g_long & X_i, std::string::iterator & itera, std::string::iterator & end) const {
 //    assert(X_i > 0 && X_i < _g.n_rules());
 
     if(_g.isTerminal(X_i))
@@ -764,6 +1924,9 @@ SelfGrammarIndex::bp_cmp_prefix(const compressed_grammar::g_long & X_i, std::str
         return 0;
     }
 
+    if(short_rules.length(X_i) > 0)
+        return short_cmp_prefix(X_i,itera,end);
+
 
     const auto& Tg = _g.get_parser_tree();
     const auto& tree = _g.get_left_trie();
@@ -822,7 +1985,7 @@ SelfGrammarIndex::bp_cmp_prefix(const compressed_grammar::g_long & X_i, std::str
         for (size_t  i = 2 ; i <= n_ch ; ++i) {
             size_t  ch = Tg.child(u,i);
 
-            int r = bp_cmp_prefix(_g[Tg.pre_order(ch)],itera,end);
+            int r = bp_cmp_prefix_tree(_g[Tg.pre_order(ch)],itera,end);
 
             if( r != 0 || itera == end)
                 return r;
@@ -836,7 +1999,7 @@ SelfGrammarIndex::bp_cmp_prefix(const compressed_grammar::g_long & X_i, std::str
 }
 
 int
-SelfGrammarIndex::bp_cmp_suffix(const compressed_grammar::g_long & X_i, std::string::iterator & itera, std::string::iterator & end) const{
+SelfGrammarIndex::bp_cmp_suffix_tree(const compressed_grammar::g_long & X_i, std::string::iterator & itera, std::string::iterator & end) const{
 
     assert(X_i > 0 && X_i < _g.n_rules());
 
@@ -851,6 +2014,9 @@ SelfGrammarIndex::bp_cmp_suffix(const compressed_grammar::g_long & X_i, std::str
 
     }
 
+    if(short_rules.length(X_i) > 0)
+        return short_cmp_suffix(X_i,itera,end);
+
     const auto &Tg = _g.get_parser_tree();
     const auto &tree = _g.get_right_trie();
     const auto &bp_rep = tree.get_tree();
@@ -909,7 +2075,7 @@ SelfGrammarIndex::bp_cmp_suffix(const compressed_grammar::g_long & X_i, std::str
         for (size_t  i = n_ch-1 ; i > 0 ; --i) {
             size_t  ch = Tg.child(u,i);
 
-            int r = bp_cmp_suffix(_g[Tg.pre_order(ch)],itera,end);
+            int r = bp_cmp_suffix_tree(_g[Tg.pre_order(ch)],itera,end);
 
             if( r != 0 || itera == end-1 )
                 return r;
@@ -927,10 +2093,15 @@ int SelfGrammarIndex::bp_cmp_suffix_grammar(const size_t & sfx, std::string::ite
 
     if(iterator1==iterator2) return 1;
 
-    const auto& parser_tree = _g.get_parser_tree();
-
     size_t sfx_preorder = grid.first_label_col(sfx);
-    size_t X = _g[sfx_preorder];
+    return bp_cmp_suffix_grammar(sfx_preorder,_g[sfx_preorder],iterator1,iterator2);
+}
+
+int SelfGrammarIndex::bp_cmp_suffix_grammar(const size_t & sfx_preorder, const size_t & X, std::string::iterator & iterator1, std::string::iterator & iterator2) const {
+
+    if(iterator1==iterator2) return 1;
+
+    const auto& parser_tree = _g.get_parser_tree();
 
     int r = bp_cmp_prefix(X,iterator1,iterator2);
 
@@ -975,7 +2146,7 @@ int SelfGrammarIndex::bp_cmp_suffix_grammar(const size_t & sfx, std::string::ite
     return r;
 }
 
-void SelfGrammarIndex::locate_ch(const char & ch, std::vector<uint> & occ) const{
+void SelfGrammarIndex::locate_ch(const char & ch, std::vector<index_long> & occ) const{
 
     const auto& alp = _g.get_alp();
 
@@ -992,7 +2163,7 @@ void SelfGrammarIndex::locate_ch(const char & ch, std::vector<uint> & occ) const
     {
         size_t node_occ_pre = _g.select_occ(X_a,i);
         size_t current = Tg[node_occ_pre];
-        auto current_parent = Tg.parent(current);
+        size_t current_parent = Tg.parent(current);
         long int p_offset = _g.offsetText(current) - _g.offsetText(current_parent) ;
         find_second_occ(p_offset,current_parent,occ);
 
@@ -1016,7 +2187,7 @@ void SelfGrammarIndex::locate_ch(const char & ch, sdsl::bit_vector & occ) const
     {
         size_t node_occ_pre = _g.select_occ(X_a,i);
         size_t current = Tg[node_occ_pre];
-        auto current_parent = Tg.parent(current);
+        size_t current_parent = Tg.parent(current);
         long int p_offset = _g.offsetText(current) - _g.offsetText(current_parent) ;
         find_second_occ(p_offset,current_parent,occ);
 
@@ -1027,12 +2198,12 @@ bool SelfGrammarIndex::expand_prefix2(const size_t & node, std::string & s, cons
 
     const auto& Tg = _g.get_parser_tree();
 
-    std::deque<std::pair<uint,std::pair<uint,uint>>> Q;
+    std::deque<std::pair<size_t,std::pair<size_t,size_t>>> Q;
 
 
 
-    uint current_leaf = Tg.leafrank(node);
-    uint last_leaf = current_leaf+Tg.leafnum(node)-1;
+    size_t current_leaf = Tg.leafrank(node);
+    size_t last_leaf = current_leaf+Tg.leafnum(node)-1;
 
 
     //Q.emplace_front(node,std::make_pair(current_leaf,last_leaf));
@@ -1313,6 +2484,7 @@ void SelfGrammarIndex::build_basics_bal(const std::string & text, fstream& R, fs
     }
     grid.code = code;
     grid.build(grid_points.begin(),grid_points.end(),not_compressed_grammar.n_rules(),num_sfx);
+    build_count();
     //std::cout<<"***************************grid size "<<grid.size_in_bytes()*1.0/1024/1024<<std::endl;
     ///grid.print_size();
     ////grid.print();
@@ -1351,22 +2523,23 @@ void SelfGrammarIndex::build_basics_bal(const std::string & text, fstream& R, fs
 void SelfGrammarIndex::load_basics(fstream & f) {
     _g.load(f);
     grid.load(f);
+    clear_query_structures();
 }
 
-void SelfGrammarIndex::find_second_occ_rec(long int off, unsigned int & prenode, std::vector<uint> & occ) const {
+void SelfGrammarIndex::find_second_occ_rec(long int off, size_t & prenode, std::vector<index_long> & occ) const {
 
     size_t Xi = _g[prenode];
     size_t n_s_occ = _g.n_occ(Xi);
     find_second_occ_rec_aux(off,prenode,occ);
     for (size_t i = 2; i <= n_s_occ; ++i)
     {
-        uint pre_node_i = _g.select_occ(Xi,i);
+        size_t pre_node_i = _g.select_occ(Xi,i);
         find_second_occ_rec_aux(off,pre_node_i,occ);
     }
 
 }
 
-void SelfGrammarIndex::find_second_occ_rec_aux(long int off, unsigned int & prenode, std::vector<uint> & occ) const {
+void SelfGrammarIndex::find_second_occ_rec_aux(long int off, size_t & prenode, std::vector<index_long> & occ) const {
 
     if(prenode == 1)
     {
@@ -1376,11 +2549,11 @@ void SelfGrammarIndex::find_second_occ_rec_aux(long int off, unsigned int & pren
 
     const auto& Tg = _g.get_parser_tree();
 
-    uint node = Tg[prenode];
+    size_t node = Tg[prenode];
 
-    uint parent = Tg.parent(node);
+    size_t parent = Tg.parent(node);
 
-    uint pre_parent = Tg.pre_order(parent);
+    size_t pre_parent = Tg.pre_order(parent);
 
     size_t Xi = _g[pre_parent];
 
@@ -1392,7 +2565,7 @@ void SelfGrammarIndex::find_second_occ_rec_aux(long int off, unsigned int & pren
 
     for (size_t i = 2; i <= n_s_occ; ++i)
     {
-        uint pre_parent_i = _g.select_occ(Xi,i);
+        size_t pre_parent_i = _g.select_occ(Xi,i);
         find_second_occ_rec(p_offset,pre_parent_i,occ);
     }
 }
@@ -1410,9 +2583,9 @@ bool SelfGrammarIndex::expand_prefix_slp(const compressed_grammar::g_long & X, s
 
 
 
-    uint pnode = _g.select_occ(X,1);
-    uint node = _g.m_tree[pnode];
-    uint len = _g.len_rule(node);
+    size_t pnode = _g.select_occ(X,1);
+    size_t node = _g.m_tree[pnode];
+    size_t len = _g.len_rule(node);
     rule_trav rt(X,len,node,_MAX_PROOF);
 
     while(true){
@@ -1454,10 +2627,10 @@ bool SelfGrammarIndex::expand_suffix_slp(const compressed_grammar::g_long & X, s
 
 
 
-    uint pnode = _g.select_occ(X,1);
-    uint node = _g.m_tree[pnode];
+    size_t pnode = _g.select_occ(X,1);
+    size_t node = _g.m_tree[pnode];
     //std::pair<uint,uint> limits = _g.limits_rule(node);
-    uint len = _g.len_rule(node);
+    size_t len = _g.len_rule(node);
     rule_trav rt(X,len,node,_MAX_PROOF);
     rt.last_processed[rt.level] = rt.len_rule[rt.level]+1;
 
@@ -1505,10 +2678,10 @@ void SelfGrammarIndex::build_bitvector_occ(sdsl::bit_vector &B) const
     sdsl::bit_vector T(size_gr*n_cols,0);
 
 
-    for (int i = 1; i <= n_cols ; ++i) {
+    for (size_t i = 1; i <= n_cols ; ++i) {
 
-        uint preorder_node = grid.first_label_col(i);
-        uint begin = i*n_cols;
+        size_t preorder_node = grid.first_label_col(i);
+        size_t begin = i*n_cols;
 
         track_occ(preorder_node,T,begin);
     }
@@ -1518,27 +2691,305 @@ void SelfGrammarIndex::build_bitvector_occ(sdsl::bit_vector &B) const
 
 }
 
-void SelfGrammarIndex::track_occ(uint &pnode, sdsl::bit_vector& B, const uint& begin) const{
+uint64_t SelfGrammarIndex::text_occ(const size_t & X, std::vector<uint64_t> & n_text_occ) const
+{
+    const auto& Tg = _g.get_parser_tree();
+
+    /*
+     * n_text_occ[X] number of occurrences of the rule X in the text (0 if it is not computed yet),
+     * it is the sum of n_text_occ over the rules of the parents of every node labeled X
+     * */
+    std::vector<size_t> S;
+    S.push_back(X);
+    while(!S.empty())
+    {
+        size_t Y = S.back();
+        if(n_text_occ[Y] != 0)
+        {
+            S.pop_back();
+            continue;
+        }
+        uint64_t sum = 0;
+        bool ready = true;
+        size_t n_s_occ = _g.n_occ(Y);
+        for (size_t i = 1; i <= n_s_occ; ++i)
+        {
+            size_t pre = _g.select_occ(Y,i);
+            if(pre == 1)
+            {
+                ++sum;
+                continue;
+            }
+            size_t Z = _g[Tg.pre_order(Tg.parent(Tg[pre]))];
+            if(n_text_occ[Z] == 0)
+            {
+                ready = false;
+                S.push_back(Z);
+            }
+            else
+                sum += n_text_occ[Z];
+        }
+        if(ready)
+        {
+            n_text_occ[Y] = sum;
+            S.pop_back();
+        }
+    }
+    return n_text_occ[X];
+}
+
+void SelfGrammarIndex::build_count()
+{
+    const auto& Tg = _g.get_parser_tree();
+
+    std::vector<uint64_t> n_text_occ(_g.n_rules()+1,0);
+
+    auto parent_rule = [&Tg,this](const size_t & pre)->size_t{
+        return _g[Tg.pre_order(Tg.parent(Tg[pre]))];
+    };
+
+    /*
+     * The weight of a point is the number of occurrences of the rule of the parent
+     * of its node (the occurrences find_second_occ reports for it)
+     * */
+    size_t n_points = grid.SB.size();
+    std::vector<uint64_t> w(n_points,0);
+    for (size_t i = 0; i < n_points; ++i)
+    {
+        size_t p = grid.first_label_col(grid.SB[i]);
+        w[i] = text_occ(parent_rule(p),n_text_occ);
+    }
+    grid.build_weights(w);
+}
+
+void SelfGrammarIndex::build_heavy_occ(const size_t & budget)
+{
+    heavy = heavy_occ();
+    if(budget == 0)
+        return;
+
+    const auto& Tg = _g.get_parser_tree();
+    size_t n_rules = _g.n_rules();
+
+    std::vector<uint64_t> n_text_occ(n_rules+1,0);
+    std::vector<std::pair<uint64_t,size_t>> rules;
+    for (size_t X = 1; X < n_rules; ++X)
+    {
+        uint64_t c = text_occ(X,n_text_occ);
+        if(c > 1)
+            rules.emplace_back(c,X);
+    }
+    std::sort(rules.begin(),rules.end(),std::greater<std::pair<uint64_t,size_t>>());
+
+    /*
+     * Greedy choice of the rules with more occurrences, an Elias-Fano list of
+     * c positions over a text of length n takes about c*(2+log(n/c)) bits
+     * */
+    uint64_t n = _g.get_size_text();
+    size_t used = 0;
+    std::vector<std::pair<uint64_t,std::vector<index_long>>> lists;
+    for (auto &&r : rules)
+    {
+        uint64_t c = r.first;
+        size_t bytes = (c*(2 + sdsl::bits::hi(n/c + 1) + 1) + 7)/8;
+        if(used + bytes > budget)
+            continue;
+        used += bytes;
+
+        std::vector<index_long> pos;
+        pos.reserve(c);
+        long int offset = 0;
+        size_t node = Tg[_g.select_occ(r.second,1)];
+        find_second_occ(offset,node,pos);
+        std::sort(pos.begin(),pos.end());
+        lists.emplace_back(r.second,std::move(pos));
+    }
+    std::sort(lists.begin(),lists.end(),[](const std::pair<uint64_t,std::vector<index_long>> & a, const std::pair<uint64_t,std::vector<index_long>> & b){
+        return a.first < b.first;
+    });
+    heavy.build(lists,n_rules,n);
+}
+
+void SelfGrammarIndex::build_fingerprints(const size_t & min_len, const uint64_t & seed)
+{
+    fp_min = min_len;
+    if(min_len == 0)
+    {
+        fingerprints.clear();
+        return;
+    }
+
+    const auto& Tg = _g.get_parser_tree();
+    size_t n_rules = _g.n_rules();
+
+    fingerprints.reset(n_rules,seed);
+
+    /*
+     * A rule is computed once the rules of the children of its first occurrence are,
+     * its length is 0 until then
+     * */
+    std::vector<size_t> S;
+    for (size_t X = 1; X < n_rules; ++X)
+    {
+        S.push_back(X);
+        while(!S.empty())
+        {
+            size_t Y = S.back();
+            if(fingerprints.length(Y) != 0)
+            {
+                S.pop_back();
+                continue;
+            }
+            if(_g.isTerminal(Y))
+            {
+                fingerprints.set(Y,karp_rabin::symbol(_g.terminal_simbol(Y)),1);
+                S.pop_back();
+                continue;
+            }
+            auto node = Tg[_g.select_occ(Y,1)];
+            size_t n_ch = Tg.children(node);
+            uint64_t h = 0, l = 0;
+            bool ready = true;
+            for (size_t i = 1; i <= n_ch; ++i)
+            {
+                size_t Z = _g[Tg.pre_order(Tg.child(node,i))];
+                if(fingerprints.length(Z) == 0)
+                {
+                    ready = false;
+                    S.push_back(Z);
+                }
+                else if(ready)
+                {
+                    h = fingerprints.concat(h,fingerprints[Z],fingerprints.length(Z));
+                    l += fingerprints.length(Z);
+                }
+            }
+            if(ready)
+            {
+                fingerprints.set(Y,h,l);
+                S.pop_back();
+            }
+        }
+    }
+    fingerprints.compress();
+}
+
+void SelfGrammarIndex::build_short_rules(const size_t & max_len)
+{
+    short_rules.clear();
+    if(max_len == 0)
+        return;
+
+    size_t n_rules = _g.n_rules();
+    rule_pool pool;
+    pool.reset(n_rules);
+
+    /*
+     * Expanding max_len+1 symbols tells apart the rules that fit
+     * */
+    std::string s(max_len + 1,0);
+    for (size_t X = 1; X < n_rules; ++X)
+    {
+        size_t pos = 0;
+        bool fits = !_g.isTerminal(X) && !bp_expand_prefix(X,s,max_len + 1,pos);
+        pool.append(X,s.data(),fits? pos : 0);
+    }
+    pool.compress();
+    short_rules = pool;
+}
+
+void SelfGrammarIndex::build_display_samples(const size_t & b)
+{
+    jump_b = b;
+    if(b == 0)
+    {
+        jump_node = sdsl::int_vector<>();
+        jump_shift = sdsl::int_vector<>();
+        jump_end = sdsl::int_vector<>();
+        return;
+    }
+
+    const auto& Tg = _g.get_parser_tree();
+    size_t n = _g.get_size_text();
+    size_t n_leaves = Tg.leafnum(Tg.root());
+    size_t n_blocks = (n + b - 1)/b;
+
+    jump_node = sdsl::int_vector<>(n_blocks,Tg.root(),64);
+    jump_shift = sdsl::int_vector<>(n_blocks,0,64);
+    jump_end = sdsl::int_vector<>(n_blocks,n-1,64);
+
+    /*
+     * Last position of the leaf l
+     * */
+    auto leaf_end = [this,&n,&n_leaves](const size_t & l)->size_t{
+        return (l == n_leaves)? n - 1 : _g.select_L(l + 1) - 1;
+    };
+
+    for (size_t k = 0; k < n_blocks; ++k)
+    {
+        size_t q = k*b, e = std::min(q + b, n) - 1;
+        size_t shift = 0; // text position - position inside the current node
+        /*
+         * Going down while the block fits in the leaf (of the current node) where it starts
+         * */
+        while(true)
+        {
+            size_t p = q - shift;
+            size_t l = _g.rank_L(p) + _g.L[p];
+            if(e - shift > leaf_end(l))
+                break;
+            auto X = _g[Tg.pre_order(Tg.leafselect(l))];
+            if(_g.isTerminal(X))
+                break;
+            auto node_def = Tg[_g.select_occ(X,1)];
+            jump_end[k] = leaf_end(l) + shift;
+            shift += _g.select_L(l) - _g.select_L(Tg.leafrank(node_def));
+            jump_node[k] = node_def;
+            jump_shift[k] = shift;
+        }
+    }
+    sdsl::util::bit_compress(jump_node);
+    sdsl::util::bit_compress(jump_shift);
+    sdsl::util::bit_compress(jump_end);
+}
+
+void SelfGrammarIndex::save_display_samples(std::fstream & f) const
+{
+    sdsl::serialize(jump_b,f);
+    sdsl::serialize(jump_node,f);
+    sdsl::serialize(jump_shift,f);
+    sdsl::serialize(jump_end,f);
+}
+
+void SelfGrammarIndex::load_display_samples(std::fstream & f)
+{
+    sdsl::load(jump_b,f);
+    sdsl::load(jump_node,f);
+    sdsl::load(jump_shift,f);
+    sdsl::load(jump_end,f);
+}
+
+void SelfGrammarIndex::track_occ(size_t &pnode, sdsl::bit_vector& B, const size_t& begin) const{
 
     if(pnode == 1)
         return;
 
-    uint pos_node = _g.m_tree[pnode];
+    size_t pos_node = _g.m_tree[pnode];
 
-    uint parent = _g.m_tree.parent(pos_node);
+    size_t parent = _g.m_tree.parent(pos_node);
 
-    uint preorder_parent = _g.m_tree.pre_order(parent);
+    size_t preorder_parent = _g.m_tree.pre_order(parent);
 
     if(_g.m_tree.isleaf(pos_node) == 1)
         B[ begin + preorder_parent - 1 ] = true;
 
-    uint label = _g[preorder_parent];
+    size_t label = _g[preorder_parent];
 
-    uint n_occ = _g.n_occ(label);
+    size_t n_occ = _g.n_occ(label);
 
-    for (int i = 2; i <= n_occ ; ++i)
+    for (size_t i = 2; i <= n_occ ; ++i)
     {
-        uint p = _g.select_occ(label,i);
+        size_t p = _g.select_occ(label,i);
         track_occ(p,B,begin);
     }
 
@@ -1844,6 +3295,7 @@ void SelfGrammarIndex::build_basics(
 
     grid.code = code;
     grid.build(grid_points.begin(),grid_points.end(),not_compressed_grammar.n_rules(),num_sfx);
+    build_count();
 #ifdef MEM_MONITOR
     stop = timer::now();
     CLogger::GetLogger()->model[BUILD_GRID] = duration_cast<microseconds>(stop-start).count();;
@@ -7,11 +7,20 @@
 
 
 #include <string>
+#include <string_view>
 #include <stack>
+#include <algorithm>
+#include <ostream>
+#include <unordered_map>
 #include <sdsl/bit_vectors.hpp>
 #include "compressed_grammar.h"
 #include "binary_relation.h"
 #include "trees/patricia_tree/compact_patricia_tree.h"
+#include "utils/rule_cache.h"
+#include "utils/heavy_occ.h"
+#include "utils/karp_rabin.h"
+#include "utils/rule_pool.h"
+#include "utils/flat_map.h"
 
 
 #ifdef MEM_MONITOR
@@ -23,10 +32,93 @@ using namespace std::chrono;
 #endif
 
 struct range{
-    uint x1,x2,y1,y2,len;
+    index_long x1,x2,y1,y2,len;
     range(){};
 };
 
+/*
+ * Frame of the depth first search of secondary occurrences (rule, offset, next occurrence, number of occurrences)
+ * */
+struct occ_frame{
+    size_t X;
+    long int off;
+    size_t i,n;
+};
+
+/*
+ * Frame of the iterative expansion of a text interval: the leaves [t,last] of the parser tree still to expand,
+ * the interval [a,b] in their positions and the rule X expanded completely from the position out of the output
+ * (X = 0 if the expansion is partial)
+ * */
+struct expand_frame{
+    size_t t,last;
+    size_t a,b;
+    size_t X,out;
+};
+
+/*
+ * Level of the descent of display: the definition node it goes down into, the shift from text
+ * positions to positions inside it and its entry of the path (leaf of the parent, end leaf)
+ * */
+struct descent_level{
+    size_t node;
+    size_t shift;
+    std::pair<size_t,size_t> leaves;
+};
+
+/*
+ * State of a binary search of a lower (upper = false) or upper bound in [lr,hr] run by batch_bound,
+ * chained marks the searches whose lr is set to the result of a previous lower bound
+ * */
+struct bound_search{
+    compressed_grammar::g_long lr{0}, hr{0};
+    bool upper{false};
+    bool chained{false};
+    bool found{false};
+};
+
+/*
+ * Rule X of the query in find_second_occ_dag: the offsets of the pattern inside it, the rules
+ * where it occurs (their entries) with the offset of each occurrence, and the number of
+ * occurrences of rules of the query inside it not yet processed
+ * */
+struct dag_rule{
+    size_t X{0};
+    std::vector<long> off;
+    std::vector<std::pair<size_t,long>> up;
+    size_t pending{0};
+    bool root{false};
+    bool heavy{false};
+    uint64_t k{0};
+};
+
+/*
+ * Scratch state of the reentrant (const) queries. Every thread keeps its own context,
+ * so one loaded index can be queried by many threads at the same time. The buffers keep
+ * their capacity among queries (they are cleared, never released), once they are warm the
+ * hot path (the split searches, find_second_occ, find_second_occ_dag, batch_bound and
+ * expand_interval_lz) does not allocate. Only the copies of the keys and occurrences put
+ * in the split/result caches on a miss do
+ * */
+struct query_context{
+    std::string pattern; // copy of the pattern, the searches work on its iterators
+    std::string key; // key of the split cache (see SelfGrammarIndexPTS::rules_range)
+    std::vector<std::pair<size_t,size_t>> path; // path of the parser tree in display
+    std::vector<descent_level> descent; // levels of the last descent of display (reused by display_batch)
+    std::vector<std::pair<size_t,size_t>> pairs; // points of a grid range
+    binary_relation::range_buffers grid_buffers;
+    std::vector<occ_frame> frames; // stack of find_second_occ
+    std::vector<expand_frame> expand; // stack of expand_interval_lz
+    flat_map expanded; // position in the output of the rules completely expanded by expand_interval_lz
+    flat_map dag_id; // entry of dag of the rules of find_second_occ_dag
+    std::vector<dag_rule> dag; // the first n_dag entries are in use, the others keep their buffers
+    size_t n_dag{0};
+    std::vector<size_t> dag_queue; // rules of find_second_occ_dag in the order they are found
+    std::vector<size_t> ready; // rules of find_second_occ_dag with all their occurrences collected
+    std::vector<size_t> active; // searches of batch_bound not finished
+    std::vector<compressed_grammar::g_long> mid; // their next probes
+};
+
 class SelfGrammarIndex {
 
 public:
@@ -39,6 +131,57 @@ public:
 protected:
     grammar_representation _g;
     range_search2d grid;
+    /*
+     * First (prefix_cache) and last (suffix_cache) symbols of the rules recently
+     * compared by the binary searches, disabled by default (see set_rule_cache)
+     * */
+    mutable rule_cache prefix_cache;
+    mutable rule_cache suffix_cache;
+    /*
+     * Optional first (rule_pfx_q) and last (rule_sfx_q, reversed) rule_q symbols of every rule
+     * packed in a word: the symbols from the most significant byte, 3 bits for the number
+     * of symbols and 1 bit set if they are the complete expansion (see build_rule_qgrams)
+     * */
+    size_t rule_q{0};
+    sdsl::int_vector<> rule_pfx_q;
+    sdsl::int_vector<> rule_sfx_q;
+    /*
+     * Optional text positions of the rules with more occurrences (see build_heavy_occ),
+     * find_second_occ reports them directly instead of going up the grammar
+     * */
+    heavy_occ heavy;
+    /*
+     * Optional Karp-Rabin fingerprints of the rules (see build_fingerprints), the comparisons
+     * of at least fp_min symbols find the longest common prefix with them
+     * */
+    karp_rabin fingerprints;
+    size_t fp_min{0};
+    /*
+     * Optional sampling of the parse tree for display (see build_display_samples): for the block of
+     * text positions [k*jump_b, (k+1)*jump_b) the deepest definition node that covers it (jump_node),
+     * the shift from text positions to the positions inside that node (jump_shift) and the last
+     * text position it covers (jump_end)
+     * */
+    size_t jump_b{0};
+    sdsl::int_vector<> jump_node;
+    sdsl::int_vector<> jump_shift;
+    sdsl::int_vector<> jump_end;
+    /*
+     * Optional complete expansions of the short rules (see build_short_rules), the expansions and
+     * comparisons copy/compare them instead of going down to the terminal rules
+     * */
+    rule_pool short_rules;
+    /*
+     * The locate of the indexes expands the secondary occurrences of every split with
+     * find_second_occ_par (see set_par_second_occ) instead of running the splits in parallel
+     * */
+    bool par_second_occ{false};
+    /*
+     * Optional parallel locate (see set_par_locate): the splits of the patterns with at least
+     * par_locate_min symbols are distributed among the OpenMP threads, the other ones run serially
+     * */
+    bool par_locate{false};
+    size_t par_locate_min{16};
 
 
 public:
@@ -48,19 +191,144 @@ public:
 
     virtual ~SelfGrammarIndex() {};
     //virtual void build(const grammar_representation&, const range_search2d& ) = 0;
-    virtual void find_ranges_trie(std::string &, std::vector<uint> &)=0;
-    virtual void find_ranges(std::string &, std::vector<uint>& )=0;
-    virtual void find_ranges_trie(std::string &, std::vector<uint>&, std::vector<range> & ) = 0;
-    virtual void find_ranges_dfs(std::string &, std::vector<uint>& )  = 0;
+    virtual void find_ranges_trie(std::string &, std::vector<index_long> &)=0;
+    virtual void find_ranges(std::string_view, std::vector<index_long>& ) const = 0;
+    virtual void find_ranges_trie(std::string &, std::vector<index_long>&, std::vector<range> & ) = 0;
+    virtual void find_ranges_dfs(std::string &, std::vector<index_long>& )  = 0;
     virtual void locate(std::string &, sdsl::bit_vector &) = 0;
-    virtual void locate(std::string &, std::vector<uint> &) = 0;
+    /*
+     * The queries do not modify the index, the pattern is copied when the search needs a
+     * mutable std::string (its iterators are used by the comparisons)
+     * */
+    virtual void locate(std::string_view, std::vector<index_long> &) const = 0;
+    /*
+     * Locate at most limit occurrences, return true if there were more occurrences (truncated result).
+     * The occurrences of every split are reported by the sink version of find_second_occ, so the
+     * search stops at the first occurrence after the limit
+     * */
+    virtual bool locate(std::string_view p, std::vector<index_long> & occ, const size_t & limit) const{
+        std::string pattern(p);
+        size_t n_occ = 0;
+        auto report = [&occ,&n_occ,&limit](const index_long & pos)->bool{
+            if(n_occ == limit) return false;
+            occ.push_back(pos);
+            ++n_occ;
+            return true;
+        };
+        if(pattern.size() == 1)
+            return !locate_ch(pattern[0],report);
+
+        query_context ctx;
+        for (size_t i = 1; i <= pattern.size(); ++i) {
+            range r;
+            if(split_range(pattern,i,r) && !find_second_occ(r.x1,r.x2,r.y1,r.y2,(long)r.len,report,ctx))
+                return true;
+        }
+        return false;
+    }
+    /*
+     * Grid range of the split p[1..i] | p[i+1..m] of the pattern (rules ending with p[1..i] and
+     * grammar suffixes starting with p[i+1..m]), return false if it is empty
+     * */
+    virtual bool split_range(std::string & pattern, const size_t & i, range & r) const = 0;
 //    virtual const m_patricia::compact_patricia_tree &get_pt_rules() const = 0;
 //    virtual const m_patricia::compact_patricia_tree &get_pt_suffixes() const = 0;
-    virtual void locateNoTrie(std::string &, std::vector<uint> &) = 0;
+    virtual void locateNoTrie(std::string_view, std::vector<index_long> &) const = 0;
+    /*
+     * Forwarding wrappers for the std::string callers (they also keep the sink templates of the
+     * derived classes from taking an occurrence vector as a sink)
+     * */
+    void locate(std::string & pattern, std::vector<index_long> & occ) const { locate(std::string_view(pattern),occ); }
+    bool locate(std::string & pattern, std::vector<index_long> & occ, const size_t & limit) const{
+        return locate(std::string_view(pattern),occ,limit);
+    }
+    void locateNoTrie(std::string & pattern, std::vector<index_long> & occ) const { locateNoTrie(std::string_view(pattern),occ); }
+    void find_ranges(std::string & pattern, std::vector<index_long> & X) const { find_ranges(std::string_view(pattern),X); }
+    /*
+     * Locate a set of patterns, occs[k] stores the occurrences of patterns[k]
+     * */
+    virtual void locate_batch(const std::vector<std::string> & patterns, std::vector<std::vector<index_long>> & occs){
+        occs.clear();
+        occs.resize(patterns.size());
+        for (size_t k = 0; k < patterns.size(); ++k) {
+            std::string pattern = patterns[k];
+            locate(pattern,occs[k]);
+        }
+    }
 
     void build_bitvector_occ(sdsl::bit_vector& B) const;
+    /*
+     * Compute the number of occurrences in the text reported by every point of the grid
+     * and build the weighted range-sum structure used by count. The weights are not part
+     * of save/load (the files of older indexes stay readable), they are kept in their own
+     * file with save_count/load_count and count falls back to locate without them
+     * */
+    void build_count();
+    void save_count(std::fstream & f) const { grid.save_SW(f); }
+    void load_count(std::fstream & f) { grid.load_SW(f); }
+    /*
+     * Use the weights of the file written by save_count in place from a read-only memory map
+     * instead of loading them, false if the file can not be mapped
+     * */
+    bool map_count(const std::string & file) { return grid.map_SW(file); }
+    /*
+     * Number of occurrences of the rule X in the text, n_text_occ memoizes the rules already computed
+     * */
+    uint64_t text_occ(const size_t & X, std::vector<uint64_t> & n_text_occ) const;
+    /*
+     * Number of occurrences of a pattern
+     * */
+    virtual size_t count(const std::string & pattern){
+        std::vector<index_long> occ;
+        std::string p = pattern;
+        locate(p,occ);
+        return occ.size();
+    }
 
     virtual void set_code(const unsigned int &c) { code = c; }
+    /*
+     * Parallelize locate inside the splits (find_second_occ_par) instead of among them, for
+     * patterns with few splits and many occurrences
+     * */
+    void set_par_second_occ(const bool & b) { par_second_occ = b; }
+    /*
+     * Run the splits of the patterns with at least min_len symbols in parallel (disabled by default,
+     * the occurrences are then reported in a nondeterministic order)
+     * */
+    void set_par_locate(const bool & b, const size_t & min_len = 16) { par_locate = b; par_locate_min = min_len; }
+    /*
+     * Keep the first/last K symbols of at most capacity rules for the comparisons (capacity = 0 disables it)
+     * */
+    void set_rule_cache(const size_t & capacity, const size_t & K){
+        prefix_cache.reset(capacity,K);
+        suffix_cache.reset(capacity,K);
+    }
+    /*
+     * Store the first/last q (at most 7, 0 removes them) symbols of every rule so the
+     * comparisons are decided with a word comparison when the rules differ in them
+     * */
+    void build_rule_qgrams(const size_t & q);
+    /*
+     * Materialize the text positions of the rules with more occurrences in the text
+     * while their Elias-Fano lists fit in budget bytes (0 removes them)
+     * */
+    void build_heavy_occ(const size_t & budget);
+    void save_heavy_occ(std::fstream & f) const { heavy.save(f); }
+    void load_heavy_occ(std::fstream & f) { heavy.load(f); }
+    /*
+     * Compute the fingerprints of the rules, the comparisons with at least min_len symbols of the
+     * pattern left use them instead of decompressing the rule (0 removes them). The base of the
+     * fingerprints is drawn from seed, it is saved with them
+     * */
+    void build_fingerprints(const size_t & min_len, const uint64_t & seed = karp_rabin::default_seed);
+    void save_fingerprints(std::fstream & f) const { sdsl::write_member(fp_min,f); fingerprints.save(f); }
+    void load_fingerprints(std::fstream & f) { sdsl::read_member(fp_min,f); fingerprints.load(f); }
+    /*
+     * Store the complete expansion of every rule with at most max_len symbols (0 removes them)
+     * */
+    void build_short_rules(const size_t & max_len);
+    void save_short_rules(std::fstream & f) const { short_rules.save(f); }
+    void load_short_rules(std::fstream & f) { short_rules.load(f); }
     virtual void build(const std::string &
 #ifdef MEM_MONITOR
             , mem_monitor& mm
@@ -95,10 +363,77 @@ public:
     virtual void load_basics(fstream &);
     virtual void save(std::fstream &);
     virtual void load(std::fstream &);
+    /*
+     * Files of an index stored one component per file (see bench/build_indices), the
+     * components with an empty name are not loaded
+     * */
+    struct component_files{
+        std::string rules_pt, sfx_pt;
+        std::string X_p, z, F, tree, L, y, alp, left_trie, right_trie;
+        std::string SL, SB, XB, XA, count;
+    };
+    /*
+     * Load the components of files. With parallel every component is read by its own task
+     * (they fill disjoint members and rebuild their own supports), otherwise one after the
+     * other. With lazy_tries the left/right tries are read on their first access. The
+     * exception of a component that fails to load reaches the caller
+     * */
+    void load_components(const component_files &, const bool & parallel, const bool & lazy_tries = false);
+    /*
+     * Drop the optional query structures and caches, they belong to the grammar loaded before
+     * */
+    virtual void clear_query_structures();
 
     virtual grammar_representation &get_grammar() { return _g; }
     virtual range_search2d &get_grid() { return grid; }
-    virtual void display(const std::size_t &, const std::size_t &, std::string &);
+    virtual void display(const std::size_t &, const std::size_t &, std::string &) const;
+    /*
+     * Reentrant display, the scratch state lives in the context
+     * */
+    void display(const std::size_t &, const std::size_t &, std::string &, query_context &) const;
+    /*
+     * display starting from the deepest level of ctx.descent whose node covers [i,j]
+     * (from the root or its sample if none) and leaving its own levels in ctx.descent
+     * */
+    void display_descent(const std::size_t & i, const std::size_t & j, std::string &, query_context & ctx) const;
+    /*
+     * Extract the text intervals [first,second] in out (in the order of intervals). The intervals
+     * are sorted and the ones overlapping or separated by at most gap symbols are extracted with
+     * a single descent of the parse tree (the text among them is decoded once). Every descent
+     * also starts from the deepest node of the previous one that covers its interval, so close
+     * intervals share the top of the descent even when they are not merged
+     * */
+    void display_batch(const std::vector<std::pair<size_t,size_t>> & intervals, std::vector<std::string> & out, query_context &, const size_t & gap = 0) const;
+    void display_batch(const std::vector<std::pair<size_t,size_t>> & intervals, std::vector<std::string> & out, const size_t & gap = 0) const{
+        query_context ctx;
+        display_batch(intervals,out,ctx,gap);
+    }
+    /*
+     * Sequential reader of the text interval [i,j] with bounded memory: a stack with the next and
+     * the end leaf of every definition in the current path of the parse tree (at most the height
+     * of the grammar), the symbols are decoded as they are read
+     * */
+    class text_reader{
+
+        protected:
+            const SelfGrammarIndex * idx;
+            std::vector<std::pair<size_t,size_t>> S;
+            size_t left;
+
+        public:
+            text_reader(const SelfGrammarIndex & _idx, const std::size_t & i, const std::size_t & j);
+            /*
+             * Copy the next (at most n) symbols in buf, return the number of symbols copied
+             * */
+            size_t read(char * buf, const size_t & n);
+            bool eof() const { return left == 0; }
+    };
+
+    text_reader open_reader(const std::size_t & i, const std::size_t & j) const { return text_reader(*this,i,j); }
+    /*
+     * Write the text interval [i,j] to out by chunks of chunk symbols
+     * */
+    void extract(const std::size_t & i, const std::size_t & j, std::ostream & out, const size_t & chunk = 1 << 16) const;
     virtual void display_trie(const std::size_t &, const std::size_t &, std::string &);
     virtual void display_L_trie(const std::size_t &i, const std::size_t &j, std::string &str) {
         str.resize(j - i + 1);
@@ -106,9 +441,45 @@ public:
         expand_interval_trie(_g.m_tree.root(), make_pair(i, j), str, p);
     }
     virtual void display_L(const std::size_t &i, const std::size_t &j, std::string &str) {
+        query_context ctx;
+        display_L(i, j, str, ctx);
+    }
+    void display_L(const std::size_t &i, const std::size_t &j, std::string &str, query_context & ctx) const {
         str.resize(j - i + 1);
         size_t p = 0;
-        expand_interval(_g.m_tree.root(), make_pair(i, j), str, p);
+        expand_interval_lz(make_pair(i, j), str, p, ctx);
+    }
+    /*
+     * Iterative expansion of the text interval range starting from the leaves of the parser tree that cover it.
+     * A rule already expanded completely inside the interval is copied from its first expansion in s
+     * (and a short rule from short_rules) instead of going down the grammar again
+     * */
+    void expand_interval_lz(const std::pair<size_t, size_t> &range, std::string &s, std::size_t &pos, query_context & ctx) const;
+    /*
+     * Sample every b text positions (0 removes them) the deepest definition node of the parse
+     * tree covering the block, display starts the descent from it
+     * */
+    void build_display_samples(const size_t & b);
+    /*
+     * Like the weights of count, the samples are not part of save/load, they are kept in their own file
+     * */
+    void save_display_samples(std::fstream & f) const;
+    void load_display_samples(std::fstream & f);
+    /*
+     * Node where the descent for [i,j] starts (the root without samples) and
+     * the shift from text positions to positions inside it
+     * */
+    void jump_start(const std::size_t & i, const std::size_t & j, size_t & node, size_t & shift) const{
+        node = _g.m_tree.root();
+        shift = 0;
+        if(jump_b == 0)
+            return;
+        size_t k = i / jump_b;
+        if(k < jump_end.size() && j <= jump_end[k])
+        {
+            node = jump_node[k];
+            shift = jump_shift[k];
+        }
     }
     virtual void display_L_rec(const std::size_t &i, const std::size_t &j, std::string &str) {
         str.resize(j - i + 1);
@@ -131,7 +502,33 @@ public:
     // protected:
 
     virtual void locate_ch(const char &, sdsl::bit_vector &) const;
-    virtual void locate_ch(const char &, std::vector<uint> &) const;
+    virtual void locate_ch(const char &, std::vector<index_long> &) const;
+    /*
+     * locate_ch reporting every occurrence to the sink report(pos),
+     * return false if the sink stopped the search
+     * */
+    template<typename F>
+    bool locate_ch(const char & ch, const F & report) const{
+
+        const auto& alp = _g.get_alp();
+        auto p = std::find(alp.begin(),alp.end(),ch);
+        if(p == alp.end()) return true;
+
+        unsigned int rk = p - alp.begin()+1;
+        auto X_a = _g.terminal_rule(rk);
+
+        const auto& Tg = _g.get_parser_tree();
+        size_t n_s_occ = _g.n_occ(X_a);
+        for (size_t i = 1; i <= n_s_occ; ++i)
+        {
+            size_t current = Tg[_g.select_occ(X_a,i)];
+            size_t current_parent = Tg.parent(current);
+            long int p_offset = _g.offsetText(current) - _g.offsetText(current_parent) ;
+            if(!find_second_occ(p_offset,current_parent,report))
+                return false;
+        }
+        return true;
+    }
 
     bool expand_prefix_slp(const grammar_representation::g_long &, std::string &, const size_t &, size_t &pos) const;
     bool expand_suffix_slp(const grammar_representation::g_long &, std::string &, const size_t &, size_t &pos) const;
@@ -145,9 +542,9 @@ public:
 
     void expand_grammar_sfx(const size_t &, std::string &, const size_t &) const;
 
-    void track_occ(uint &, sdsl::bit_vector& , const uint& )const;
+    void track_occ(size_t &, sdsl::bit_vector& , const size_t& )const;
 
-    void find_second_occ(uint r1,uint r2,uint c1,uint c2, long len, std::vector<uint> &occ){
+    void find_second_occ(index_long r1,index_long r2,index_long c1,index_long c2, long len, std::vector<index_long> &occ) const{
 
         const auto& g_tree = _g.get_parser_tree();
 
@@ -160,20 +557,133 @@ public:
             size_t p = grid.first_label_col(pair.second);
             size_t pos_p = _g.offsetText(g_tree[p]);
 
-            unsigned int parent = g_tree.parent(g_tree[p]);
+            size_t parent = g_tree.parent(g_tree[p]);
             long  l = long (- len + pos_p) - _g.offsetText(parent);
             find_second_occ(l,parent,occ);
         }
 
     }
 
-    void find_second_occ(long int &, unsigned int &, sdsl::bit_vector &) const;
+    /*
+     * Parallel version of find_second_occ, the secondary occurrences of the
+     * points in the grid range are expanded by all the threads (work stealing).
+     * Called inside a parallel region it runs find_second_occ instead
+     * */
+    void find_second_occ_par(index_long r1,index_long r2,index_long c1,index_long c2, long len, std::vector<index_long> &occ) const;
+    /*
+     * Version of find_second_occ that groups the primary occurrences by rule and
+     * pushes the offsets of each rule up the grammar only once, visiting the rules
+     * in topological order (a rule is processed after all its occurrences inside
+     * other rules of the query were collected)
+     * */
+    void find_second_occ_dag(index_long r1,index_long r2,index_long c1,index_long c2, long len, std::vector<index_long> &occ) const;
+    /*
+     * The points of the range, the rules of the query and their offsets use the buffers of ctx
+     * */
+    void find_second_occ_dag(index_long r1,index_long r2,index_long c1,index_long c2, long len, std::vector<index_long> &occ, query_context & ctx) const;
+    /*
+     * Plain breadth first expansion (no heavy lists, grouping or threads), the reference
+     * the other versions of find_second_occ are checked against (see bench/bm_check.cpp)
+     * */
+    void find_second_occ_plain(index_long r1,index_long r2,index_long c1,index_long c2, long len, std::vector<index_long> &occ) const;
+
+    void find_second_occ(long int &, size_t &, sdsl::bit_vector &) const;
+
+    void find_second_occ_rec(long int, size_t &, std::vector<index_long> &) const;
+
+    void find_second_occ_rec_aux(long int, size_t &, std::vector<index_long> &) const;
+
+    void find_second_occ(long int &, size_t &, std::vector<index_long> &) const;
+
+    /*
+     * Sink versions of find_second_occ, every occurrence is reported to report(pos) as soon as
+     * it is found and the search stops when report returns false (the function returns false).
+     * */
+    template<typename F>
+    bool find_second_occ(index_long r1,index_long r2,index_long c1,index_long c2, long len, const F & report) const{
+        query_context ctx;
+        return find_second_occ(r1,r2,c1,c2,len,report,ctx);
+    }
+    /*
+     * The points of the range and the search stacks use the buffers of ctx
+     * */
+    template<typename F>
+    bool find_second_occ(index_long r1,index_long r2,index_long c1,index_long c2, long len, const F & report, query_context & ctx) const{
+
+        const auto& g_tree = _g.get_parser_tree();
+
+        auto& pairs = ctx.pairs;
+        grid.range2(r1,r2,c1,c2,pairs,ctx.grid_buffers);
+
+        for (auto &pair : pairs) {
+            size_t p = grid.first_label_col(pair.second);
+            size_t pos_p = _g.offsetText(g_tree[p]);
+
+            size_t parent = g_tree.parent(g_tree[p]);
+            long  l = long (- len + pos_p) - _g.offsetText(parent);
+            if(!find_second_occ(l,parent,report,ctx.frames))
+                return false;
+        }
+        return true;
+    }
+    /*
+     * Depth first instead of breadth first, the stack keeps one frame (rule, offset, next occurrence)
+     * per level of the grammar so its size does not depend on the number of occurrences
+     * */
+    template<typename F>
+    bool find_second_occ(long int & offset, size_t & node, const F & report) const{
+        std::vector<occ_frame> S;
+        return find_second_occ(offset,node,report,S);
+    }
+
+    template<typename F>
+    bool find_second_occ(long int & offset, size_t & node, const F & report, std::vector<occ_frame> & S) const{
 
-    void find_second_occ_rec(long int, unsigned int &, std::vector<uint> &) const;
+        const auto& Tg = _g.get_parser_tree();
+        S.clear();
+        {
+            size_t Xi = _g[Tg.pre_order(node)];
+            uint64_t k;
+            if(heavy.find(Xi,k))
+                return heavy.report(k,offset,report);
+            S.push_back({Xi,offset,1,_g.n_occ(Xi)});
+        }
 
-    void find_second_occ_rec_aux(long int, unsigned int &, std::vector<uint> &) const;
+        while(!S.empty())
+        {
+            if(S.back().i > S.back().n)
+            {
+                S.pop_back();
+                continue;
+            }
 
-    void find_second_occ(long int &, unsigned int &, std::vector<uint> &) const;
+            size_t pre = _g.select_occ(S.back().X,S.back().i);
+            long int off = S.back().off;
+            ++S.back().i;
+
+            if(pre == 1)
+            {
+                if(!report((index_long)off))
+                    return false;
+            }
+            else
+            {
+                auto _node = Tg[pre];
+                size_t parent = Tg.parent(_node);
+                size_t Xi = _g[Tg.pre_order(parent)];
+                long int p_offset = off + _g.offsetText(_node) - _g.offsetText(parent);
+                uint64_t k;
+                if(heavy.find(Xi,k))
+                {
+                    if(!heavy.report(k,p_offset,report))
+                        return false;
+                    continue;
+                }
+                S.push_back({Xi,p_offset,1,_g.n_occ(Xi)});
+            }
+        }
+        return true;
+    }
 
 
     template<typename K>
@@ -242,6 +752,71 @@ public:
 
     }
 
+    /*
+     * Run the binary searches of S interleaved (same results as lower_bound/upper_bound on each one).
+     * Every round first calls prefetch(k,mid) with the next probe of every active search and then
+     * compares them with f(k,mid), so the cache misses of the probes of different searches overlap
+     * instead of being paid one after the other. f(k,a) is always preceded by prefetch(k,a) and
+     * may use the state it leaves. The active searches and their probes are kept in the buffers of ctx
+     * */
+    template<typename K, typename P>
+    void batch_bound(std::vector<bound_search> & S, const K &f, const P &prefetch, query_context & ctx) const {
+
+        auto& active = ctx.active;
+        auto& mid = ctx.mid;
+        active.clear();
+        if(mid.size() < S.size())
+            mid.resize(S.size());
+
+        for (size_t k = 0; k < S.size(); ++k) {
+            S[k].found = false;
+            if(S[k].lr < S[k].hr)
+                active.push_back(k);
+        }
+
+        while(!active.empty()){
+
+            for (auto &&k : active) {
+                mid[k] = S[k].upper ? (S[k].lr + S[k].hr + 1)/2 : (S[k].lr + S[k].hr)/2;
+                prefetch(k,mid[k]);
+            }
+
+            size_t n_active = 0;
+            for (size_t j = 0; j < active.size(); ++j) {
+                size_t k = active[j];
+                auto &s = S[k];
+                int c = f(k,mid[k]);
+                if(c < 0){
+                    /*the rule is greater than the pattern */
+                    s.hr = mid[k] - 1;
+                }else{
+                    if(c > 0)
+                        s.lr = mid[k] + 1;
+                    else{
+                        if(s.upper) s.lr = mid[k];
+                        else s.hr = mid[k];
+                        s.found = true;
+                    }
+                }
+                if(s.lr < s.hr)
+                    active[n_active++] = k;
+            }
+            active.resize(n_active);
+        }
+
+        /*
+         * Last probe of the searches that did not find the bound
+         * */
+        for (size_t k = 0; k < S.size(); ++k)
+            if(!S[k].found && S[k].lr == S[k].hr)
+                active.push_back(k);
+        for (auto &&k : active)
+            prefetch(k,S[k].lr);
+        for (auto &&k : active)
+            if(f(k,S[k].lr) == 0)
+                S[k].found = true;
+    }
+
 
     template<typename K>
     bool lower_bound(grammar_representation::g_long &lr, grammar_representation::g_long &hr, const K &f) const {
@@ -327,13 +902,84 @@ public:
 
     virtual int cmp_suffix(const grammar_representation::g_long &, std::string::iterator &, std::string::iterator &) const;
 
-    int cmp_suffix_grammar(const size_t &, std::string::iterator &, std::string::iterator &);
+    int cmp_suffix_grammar(const size_t &, std::string::iterator &, std::string::iterator &) const;
 
     int bp_cmp_prefix(const grammar_representation::g_long &, std::string::iterator &, std::string::iterator &) const;
 
     int bp_cmp_suffix(const grammar_representation::g_long &, std::string::iterator &, std::string::iterator &) const;
 
+    int bp_cmp_prefix_tree(const grammar_representation::g_long &, std::string::iterator &, std::string::iterator &) const;
+
+    int bp_cmp_suffix_tree(const grammar_representation::g_long &, std::string::iterator &, std::string::iterator &) const;
+    /*
+     * Compare against the symbols stored in the rule cache (decoding the rule if it is not there),
+     * return false if the cached symbols are not enough to decide the comparison
+     * */
+    bool cached_cmp_prefix(const grammar_representation::g_long &, std::string::iterator &, std::string::iterator &, int &) const;
+
+    bool cached_cmp_suffix(const grammar_representation::g_long &, std::string::iterator &, std::string::iterator &, int &, const bool & trie) const;
+    /*
+     * Compare against the packed symbols of build_rule_qgrams,
+     * return false if they are not enough to decide the comparison
+     * */
+    bool qgram_cmp_prefix(const grammar_representation::g_long &, std::string::iterator &, std::string::iterator &, int &) const;
+
+    bool qgram_cmp_suffix(const grammar_representation::g_long &, std::string::iterator &, std::string::iterator &, int &) const;
+    /*
+     * Fingerprints of the prefix/suffix of length l of the expansion of X,
+     * found going down the parser tree from the first occurrence of X
+     * */
+    uint64_t fp_prefix(grammar_representation::g_long X, size_t l) const;
+
+    uint64_t fp_suffix(grammar_representation::g_long X, size_t l) const;
+    /*
+     * l-th symbol (from 0) of the expansion of X, from the left or from the right (reverse)
+     * */
+    unsigned char rule_symbol(grammar_representation::g_long X, size_t l, const bool & reverse) const;
+    /*
+     * Longest common prefix of the expansion of X and the m symbols of the pattern from itera
+     * (forward), or of the reversed expansion and the m symbols from itera backward (fp_lcp_suffix)
+     * */
+    size_t fp_lcp_prefix(const grammar_representation::g_long & X, const std::string::iterator & itera, const size_t & m) const;
+
+    size_t fp_lcp_suffix(const grammar_representation::g_long & X, const std::string::iterator & itera, const size_t & m) const;
+    /*
+     * Compare with the fingerprints when at least fp_min symbols of the pattern are left,
+     * return false if they are not used
+     * */
+    bool fp_cmp_prefix(const grammar_representation::g_long &, std::string::iterator &, std::string::iterator &, int &) const;
+
+    bool fp_cmp_suffix(const grammar_representation::g_long &, std::string::iterator &, std::string::iterator &, int &) const;
+    /*
+     * Copy the stored expansion of the short rule X (reversed for the suffixes) until l symbols
+     * are written, return true if l is reached
+     * */
+    bool short_expand(const grammar_representation::g_long & X, std::string & s, const size_t & l, size_t & pos, const bool & reverse) const;
+    /*
+     * Compare the pattern with the stored expansion of the short rule X, forward from itera
+     * (short_cmp_prefix) or backward (short_cmp_suffix) like the tree comparisons
+     * */
+    int short_cmp_prefix(const grammar_representation::g_long & X, std::string::iterator & itera, std::string::iterator & end) const;
+
+    int short_cmp_suffix(const grammar_representation::g_long & X, std::string::iterator & itera, std::string::iterator & end) const;
+    /*
+     * Bring to the cache the q-gram word of the rule X before comparing with it
+     * */
+    void prefetch_rule_prefix(const grammar_representation::g_long & X) const{
+        if(rule_q > 0 && X < rule_pfx_q.size())
+            __builtin_prefetch(rule_pfx_q.data() + (X*rule_pfx_q.width())/64);
+    }
+
+    void prefetch_rule_suffix(const grammar_representation::g_long & X) const{
+        if(rule_q > 0 && X < rule_sfx_q.size())
+            __builtin_prefetch(rule_sfx_q.data() + (X*rule_sfx_q.width())/64);
+    }
+
     int bp_cmp_suffix_grammar(const size_t &, std::string::iterator &, std::string::iterator &) const;
+    /*
+     * Same comparison for a suffix whose first node (preorder) and its rule X are already known
+     * */
+    int bp_cmp_suffix_grammar(const size_t & sfx_preorder, const size_t & X, std::string::iterator &, std::string::iterator &) const;
 
 
     virtual void load_rules_pt(fstream &f) = 0;
@@ -881,13 +1527,17 @@ public:
             ++pos;
             return;
         }
+        if(short_rules.length(X) > 0){
+            short_expand(X,s,l,pos,false);
+            return;
+        }
 
-        uint rule_node = _g.m_tree[_g.select_occ(X,1)];
+        size_t rule_node = _g.m_tree[_g.select_occ(X,1)];
 
-        uint nch  = _g.m_tree.children(rule_node);
+        size_t nch  = _g.m_tree.children(rule_node);
         for (int j = 1; j <= nch ; ++j)
-        {   uint child = _g.m_tree.child(rule_node,j);
-            uint V = _g[_g.m_tree.pre_order(child)];
+        {   size_t child = _g.m_tree.child(rule_node,j);
+            size_t V = _g[_g.m_tree.pre_order(child)];
             dfs_expand_prefix(V,s,l,pos);
 
             if(l == pos ) return ;
@@ -1001,15 +1651,19 @@ public:
             ++pos;
             return;
         }
+        if(short_rules.length(X) > 0){
+            short_expand(X,s,l,pos,true);
+            return;
+        }
 
-        uint rule_node = _g.m_tree[_g.select_occ(X,1)];
+        size_t rule_node = _g.m_tree[_g.select_occ(X,1)];
 
-        uint nch  = _g.m_tree.children(rule_node);
+        size_t nch  = _g.m_tree.children(rule_node);
 
         for (int j = nch; j > 0 ; --j)
         {
-            uint child = _g.m_tree.child(rule_node,j);
-            uint V = _g[_g.m_tree.pre_order(child)];
+            size_t child = _g.m_tree.child(rule_node,j);
+            size_t V = _g[_g.m_tree.pre_order(child)];
             dfs_expand_suffix(V,s,l,pos);
             if(pos == l)return;
         }
@@ -1145,7 +1799,7 @@ public:
 
                 /* compute new range */
 
-                uint off = range.second - plle + 1;
+                size_t off = range.second - plle + 1;
 
                 dfs_expand_prefix(X,s,pos+off,pos);
             }
@@ -1155,6 +1809,19 @@ public:
     }
 
     virtual int  dfs_cmp_suffix    (const grammar_representation::g_long & X, std::string::iterator & itera, std::string::iterator & end) const{
+        int r;
+        if(short_rules.length(X) > 0)
+            return short_cmp_suffix(X,itera,end);
+        if(qgram_cmp_suffix(X,itera,end,r))
+            return r;
+        if(fp_cmp_suffix(X,itera,end,r))
+            return r;
+        if(cached_cmp_suffix(X,itera,end,r,false))
+            return r;
+        return dfs_cmp_suffix_tree(X,itera,end);
+    }
+
+    virtual int  dfs_cmp_suffix_tree (const grammar_representation::g_long & X, std::string::iterator & itera, std::string::iterator & end) const{
 
         if(_g.isTerminal(X) ){
 
@@ -1166,17 +1833,19 @@ public:
             if(itera == end-1) return 0;
             return 0;
         }
+        if(short_rules.length(X) > 0)
+            return short_cmp_suffix(X,itera,end);
 
 
 
-        uint rule_node = _g.m_tree[_g.select_occ(X,1)];
+        size_t rule_node = _g.m_tree[_g.select_occ(X,1)];
 
-        uint nch  = _g.m_tree.children(rule_node);
+        size_t nch  = _g.m_tree.children(rule_node);
 
         for (int j = nch; j > 0 ; --j)
-        {   uint child = _g.m_tree.child(rule_node,j);
-            uint V = _g[_g.m_tree.pre_order(child)];
-            int r = dfs_cmp_suffix(V,itera,end);
+        {   size_t child = _g.m_tree.child(rule_node,j);
+            size_t V = _g[_g.m_tree.pre_order(child)];
+            int r = dfs_cmp_suffix_tree(V,itera,end);
             if(r != 0) return r;
             if(itera == end - 1)
                 return 0;
@@ -1191,7 +1860,7 @@ public:
 
         if(_g.m_tree.isleaf(node)){
 
-            uint X = _g[_g.m_tree.pre_order(node)];
+            size_t X = _g[_g.m_tree.pre_order(node)];
 
             if(_g.isTerminal(X) ){
 
@@ -1207,7 +1876,7 @@ public:
             rule_node = _g.m_tree[_g.select_occ(X,1)];
         }
 
-        uint nch  = _g.m_tree.children(rule_node);
+        size_t nch  = _g.m_tree.children(rule_node);
 
         for (int j = nch; j > 0 ; --j)
         {
@@ -1237,13 +1906,15 @@ public:
             if(itera == end) return 0;
             return 0;
         }
+        if(short_rules.length(X) > 0)
+            return short_cmp_prefix(X,itera,end);
 
-        uint rule_node = _g.m_tree[_g.select_occ(X,1)];
+        size_t rule_node = _g.m_tree[_g.select_occ(X,1)];
 
-        uint nch  = _g.m_tree.children(rule_node);
+        size_t nch  = _g.m_tree.children(rule_node);
         for (int j = 1; j <= nch ; ++j)
-        {   uint child = _g.m_tree.child(rule_node,j);
-            uint V = _g[_g.m_tree.pre_order(child)];
+        {   size_t child = _g.m_tree.child(rule_node,j);
+            size_t V = _g[_g.m_tree.pre_order(child)];
             int r = dfs_cmp_prefix(V,itera,end);
             if(r != 0) return r;
             if(r == 0 && itera == end)
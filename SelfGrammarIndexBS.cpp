@@ -114,7 +114,7 @@ void SelfGrammarIndexBS::locate2( std::string & pattern, sdsl::bit_vector & occ)
         for (auto &pair : pairs) {
             size_t p = grid.first_label_col(pair.second);
             size_t pos_p = _g.offsetText(g_tree[p]);
-            unsigned int parent = g_tree.parent(g_tree[p]);
+            size_t parent = g_tree.parent(g_tree[p]);
             long   l = long (- len + pos_p) - _g.offsetText(parent);
             if(mark[p] == false)
             {
@@ -220,7 +220,7 @@ void SelfGrammarIndexBS::locate( std::string & pattern, sdsl::bit_vector & occ){
         for (auto &pair : pairs) {
             size_t p = grid.first_label_col(pair.second);
             size_t pos_p = _g.offsetText(g_tree[p]);
-            unsigned int parent = g_tree.parent(g_tree[p]);
+            size_t parent = g_tree.parent(g_tree[p]);
             long   l = long (- len + pos_p) - _g.offsetText(parent);
             find_second_occ(l,parent,occ);
         }
@@ -229,7 +229,9 @@ void SelfGrammarIndexBS::locate( std::string & pattern, sdsl::bit_vector & occ){
 
 
 }
-void SelfGrammarIndexBS::locate( std::string & pattern, std::vector<uint> & occ){
+void SelfGrammarIndexBS::locate( std::string_view p, std::vector<index_long> & occ) const{
+
+    std::string pattern(p);
 
     if(pattern.size() == 1)
     {
@@ -239,99 +241,123 @@ void SelfGrammarIndexBS::locate( std::string & pattern, std::vector<uint> & occ)
 
 
     size_t p_n = pattern.size();
-    size_t n_xj = _g.n_rules()-1;
-    size_t n_sj = grid.n_columns();
     /*
      *
      * partitioning the pattern
+     * in the parallel mode (see set_par_locate) each thread keeps
+     * the occurrences of its partitions, they are merged at the end
      *
      * */
-    for (size_t  i = 1; i <= p_n ; ++i)
+    bool par = par_locate && p_n >= par_locate_min;
+#pragma omp parallel if(par)
     {
+        std::vector<index_long> t_occ;
+        auto& out = par ? t_occ : occ;
 
+#pragma omp for schedule(dynamic) nowait
+        for (size_t  i = 1; i <= p_n ; ++i)
+        {
+            range r;
+            if(!split_range(pattern, i, r))
+                continue;
 
-        auto itera = pattern.begin() + i-1;
-        grammar_representation::g_long lr = 1,hr = n_xj;
-
-        bool found = false;
+            long len = r.len;
+            find_second_occ(r.x1,r.x2,r.y1,r.y2,len,out);
+        }
 
-        lower_bound(found,lr,hr,[&itera,&pattern,this](const grammar_representation::g_long & a)->int
+        if(par)
         {
-            auto begin = pattern.begin();
-            auto end = itera;
-            auto r =  bp_cmp_suffix(a,end,begin);
-            if(r == 0 && end != begin-1) return 1;
-            return r;
-        });
+#pragma omp critical
+            occ.insert(occ.end(),t_occ.begin(),t_occ.end());
+        }
+    }
 
+}
 
-        if(!found)
-            continue;
+bool SelfGrammarIndexBS::split_range(std::string & pattern, const size_t & i, range & rg) const {
 
-        binary_relation::bin_long r1 = lr;
-        hr = n_xj;
+    size_t n_xj = _g.n_rules()-1;
+    size_t n_sj = grid.n_columns();
 
-        found = false;
-        upper_bound(found,lr,hr,[&itera,&pattern,this](const grammar_representation::g_long & a)->int
-        {
-            auto begin = pattern.begin();
-            auto end = itera;
-            auto r =  bp_cmp_suffix(a,end,begin);
-            if(r == 0 && end != begin-1) return 1;
+    auto itera = pattern.begin() + i-1;
+    grammar_representation::g_long lr = 1,hr = n_xj;
 
-            return r;
-        });
-        if(!found)
-            continue;
+    bool found = false;
 
-        binary_relation::bin_long r2 = hr;
+    lower_bound(found,lr,hr,[&itera,&pattern,this](const grammar_representation::g_long & a)->int
+    {
+        auto begin = pattern.begin();
+        auto end = itera;
+        auto r =  bp_cmp_suffix(a,end,begin);
+        if(r == 0 && end != begin-1) return 1;
+        return r;
+    });
 
 
-        grammar_representation::g_long ls = 1,hs = n_sj;
+    if(!found)
+        return false;
 
-        found = false;
-        lower_bound(found, ls,hs,[&itera,&pattern,this](const grammar_representation::g_long & a)->int
-        {
-            auto end = pattern.end();
-            auto it2 = itera+1;
-            auto r = bp_cmp_suffix_grammar(a,it2,end);
+    binary_relation::bin_long r1 = lr;
+    hr = n_xj;
 
-            return r;
-        });
+    found = false;
+    upper_bound(found,lr,hr,[&itera,&pattern,this](const grammar_representation::g_long & a)->int
+    {
+        auto begin = pattern.begin();
+        auto end = itera;
+        auto r =  bp_cmp_suffix(a,end,begin);
+        if(r == 0 && end != begin-1) return 1;
 
-        if(!found)
-            continue;
-        binary_relation::bin_long c1 = ls;
-        hs = n_sj;
+        return r;
+    });
+    if(!found)
+        return false;
 
-        found = false;
+    binary_relation::bin_long r2 = hr;
 
-        upper_bound(found,ls,hs,[&itera,&pattern,this](const grammar_representation::g_long & a)->int
-        {
-            auto end = pattern.end();
-            auto it2 = itera+1;
-            auto r =  bp_cmp_suffix_grammar(a,it2,end);
-            return r;
-        });
 
-        if(!found)
-            continue;
+    grammar_representation::g_long ls = 1,hs = n_sj;
 
+    found = false;
+    lower_bound(found, ls,hs,[&itera,&pattern,this](const grammar_representation::g_long & a)->int
+    {
+        auto end = pattern.end();
+        auto it2 = itera+1;
+        auto r = bp_cmp_suffix_grammar(a,it2,end);
 
-        binary_relation::bin_long c2 = hs;
+        return r;
+    });
 
-        long len = itera-pattern.begin() +1;
+    if(!found)
+        return false;
+    binary_relation::bin_long c1 = ls;
+    hs = n_sj;
 
+    found = false;
 
-        find_second_occ(r1,r2,c1,c2,len,occ);
+    upper_bound(found,ls,hs,[&itera,&pattern,this](const grammar_representation::g_long & a)->int
+    {
+        auto end = pattern.end();
+        auto it2 = itera+1;
+        auto r =  bp_cmp_suffix_grammar(a,it2,end);
+        return r;
+    });
 
+    if(!found)
+        return false;
 
 
-    }
+    binary_relation::bin_long c2 = hs;
 
+    long len = itera-pattern.begin() +1;
 
+    rg.x1 = r1; rg.x2 = r2; rg.y1 = c1; rg.y2 = c2; rg.len = len;
+    return true;
 }
-void SelfGrammarIndexBS::locateNoTrie( std::string & pattern, std::vector<uint> & occ){
+
+void SelfGrammarIndexBS::locateNoTrie( std::string_view p, std::vector<index_long> & occ) const{
+
+    std::string pattern(p);
 
 
     size_t p_n = pattern.size();
@@ -422,7 +448,7 @@ void SelfGrammarIndexBS::locateNoTrie( std::string & pattern, std::vector<uint>
 
 
 }
-void SelfGrammarIndexBS::display(const std::size_t &i, const std::size_t &j, std::string &s) {
+void SelfGrammarIndexBS::display(const std::size_t &i, const std::size_t &j, std::string &s) const {
     SelfGrammarIndex::display( i,j,s);
 }
 void SelfGrammarIndexBS::display_trie(const std::size_t &i, const std::size_t &j, std::string &s) {
@@ -436,7 +462,7 @@ size_t SelfGrammarIndexBS::size_in_bytes() const {
 //    std::cout<<"SelfGrammarIndexBS::size_in_bytes()\n";
     return SelfGrammarIndex::size_in_bytes();
 }
-void SelfGrammarIndexBS::find_ranges_trie(std::string & pattern, std::vector<uint>&X) {
+void SelfGrammarIndexBS::find_ranges_trie(std::string & pattern, std::vector<index_long>&X) {
 
     size_t p_n = pattern.size();
     size_t n_xj = _g.n_rules()-1;
@@ -459,7 +485,7 @@ void SelfGrammarIndexBS::find_ranges_trie(std::string & pattern, std::vector<uin
             continue;
    }
 }
-void SelfGrammarIndexBS::find_ranges_trie(std::string & pattern, std::vector<uint>&X, std::vector<range>& fr) {
+void SelfGrammarIndexBS::find_ranges_trie(std::string & pattern, std::vector<index_long>&X, std::vector<range>& fr) {
 
     size_t p_n = pattern.size();
     size_t n_sj = grid.n_columns();
@@ -496,7 +522,9 @@ void SelfGrammarIndexBS::find_ranges_trie(std::string & pattern, std::vector<uin
             continue;
     }
 }
-void SelfGrammarIndexBS::find_ranges(std::string &pattern, std::vector<uint> &X) {
+void SelfGrammarIndexBS::find_ranges(std::string_view p, std::vector<index_long> &X) const {
+
+    std::string pattern(p);
 
     size_t p_n = pattern.size();
     size_t n_xj = _g.n_rules()-1;
@@ -530,7 +558,7 @@ void SelfGrammarIndexBS::find_ranges(std::string &pattern, std::vector<uint> &X)
     }
 
 }
-void SelfGrammarIndexBS::find_ranges_dfs(std::string & pattern, std::vector<uint>&X) {
+void SelfGrammarIndexBS::find_ranges_dfs(std::string & pattern, std::vector<index_long>&X) {
 
     size_t p_n = pattern.size();
     size_t n_xj = _g.n_rules()-1;
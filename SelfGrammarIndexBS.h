@@ -54,16 +54,20 @@ public:
         );
     }
     void build(const grammar_representation&, const range_search2d& );
-    void find_ranges_dfs(std::string &, std::vector<uint>& ) override;
-    void find_ranges_trie(std::string &, std::vector<uint>& ) override;
-    void find_ranges_trie(std::string &, std::vector<uint>&, std::vector<range> & ) override;
-    void find_ranges(std::string &, std::vector<uint>& ) override;
-
+    void find_ranges_dfs(std::string &, std::vector<index_long>& ) override;
+    void find_ranges_trie(std::string &, std::vector<index_long>& ) override;
+    void find_ranges_trie(std::string &, std::vector<index_long>&, std::vector<range> & ) override;
+    void find_ranges(std::string_view, std::vector<index_long>& ) const override;
+
+    using SelfGrammarIndex::locate;
+    using SelfGrammarIndex::locateNoTrie;
+    using SelfGrammarIndex::find_ranges;
     void locate( std::string& , sdsl::bit_vector &) override;
-    void locate( std::string& , std::vector<uint> &) override;
+    void locate( std::string_view , std::vector<index_long> &) const override;
+    bool split_range(std::string &, const size_t &, range &) const override;
     void locate2( std::string& , sdsl::bit_vector &) ;
-    void locateNoTrie( std::string &, std::vector<uint> &) override;
-    void display(const std::size_t& , const std::size_t&, std::string & ) override ;
+    void locateNoTrie( std::string_view, std::vector<index_long> &) const override;
+    void display(const std::size_t& , const std::size_t&, std::string & ) const override ;
     void display_trie(const std::size_t& , const std::size_t&, std::string & ) override ;
     void display_L_trie(const std::size_t& i, const std::size_t& j, std::string & s) override {
         SelfGrammarIndex::display_L_trie(i,j,s);
@@ -100,7 +104,7 @@ public:
     }
 
 
-    void test_findSecondOcc(long len, uint &x1,  uint &x2, uint &y1, uint &y2,std::vector<uint> &occ){
+    void test_findSecondOcc(long len, index_long &x1,  index_long &x2, index_long &y1, index_long &y2,std::vector<index_long> &occ){
 
         const auto& g_tree = _g.get_parser_tree();
         std::vector< std::pair<size_t,size_t> > pairs;
@@ -110,14 +114,14 @@ public:
         for (auto &pair : pairs){
             size_t p = grid.first_label_col(pair.second);
             size_t pos_p = _g.offsetText(g_tree[p]);
-            unsigned int parent = g_tree.parent(g_tree[p]);
+            size_t parent = g_tree.parent(g_tree[p]);
             long int  l = long (- len + pos_p) - _g.offsetText(parent);
-            unsigned int pre_parent = g_tree.pre_order(parent);
+            size_t pre_parent = g_tree.pre_order(parent);
             find_second_occ_rec(l,pre_parent,occ);
         }
 
     }
-    void test_findSecondOcc2(long len, uint &x1,  uint &x2, uint &y1, uint &y2,std::vector<uint> &occ){
+    void test_findSecondOcc2(long len, index_long &x1,  index_long &x2, index_long &y1, index_long &y2,std::vector<index_long> &occ){
 
         const auto& g_tree = _g.get_parser_tree();
         std::vector< std::pair<size_t,size_t> > pairs;
@@ -127,7 +131,7 @@ public:
         for (auto &pair : pairs){
             size_t p = grid.first_label_col(pair.second);
             size_t pos_p = _g.offsetText(g_tree[p]);
-            unsigned int parent = g_tree.parent(g_tree[p]);
+            size_t parent = g_tree.parent(g_tree[p]);
             long int  l = long (- len + pos_p) - _g.offsetText(parent);
             //unsigned int pre_parent = g_tree.pre_order(parent);
             find_second_occ(l,parent,occ);
@@ -1108,7 +1108,7 @@ public:
                sdsl::size_in_bytes(c_sel1) + sdsl::size_in_bytes(c_rank1);
     }
 
-    virtual void qgram_locate( std::string & pattern, std::vector<uint> & occ){
+    virtual void qgram_locate( std::string & pattern, std::vector<index_long> & occ){
 
         if(pattern.size() == 1)
         {
@@ -1124,98 +1124,107 @@ public:
         /*
          *
          * partitioning the pattern
+         * in the parallel mode (see set_par_locate) each thread keeps
+         * the occurrences of its partitions, they are merged at the end
          *
          * */
-        for (size_t  i = 1; i <= p_n ; ++i)
+        bool par = par_locate && p_n >= par_locate_min;
+#pragma omp parallel if(par)
         {
+            std::vector<index_long> t_occ;
+            auto& out = par ? t_occ : occ;
 
-            auto itera = pattern.begin() + i-1;
+#pragma omp for schedule(dynamic) nowait
+            for (size_t  i = 1; i <= p_n ; ++i)
+            {
 
+                auto itera = pattern.begin() + i-1;
 
-            grammar_representation::g_long lr = 1, hr = n_xj;
 
-            bool found = false;
+                grammar_representation::g_long lr = 1, hr = n_xj;
 
-            lower_bound(found,lr,hr,[&itera,&pattern,this](const grammar_representation::g_long & a)->int
-            {
-                auto begin = pattern.begin()-1;
-                auto end = itera;
+                bool found = false;
 
-                auto r =  match_suffix(a,end,begin);
+                lower_bound(found,lr,hr,[&itera,&pattern,this](const grammar_representation::g_long & a)->int
+                {
+                    auto begin = pattern.begin()-1;
+                    auto end = itera;
 
-                if(r == 0 && begin != end) return 1;
+                    auto r =  match_suffix(a,end,begin);
 
-                return r;
-            });
+                    if(r == 0 && begin != end) return 1;
 
-            if(!found)
-                continue;
+                    return r;
+                });
 
-            binary_relation::bin_long r1 = lr;
-            hr = n_xj;//right > n_xj?n_xj:right;
+                if(!found)
+                    continue;
+
+                binary_relation::bin_long r1 = lr;
+                hr = n_xj;//right > n_xj?n_xj:right;
 
 //            std::cout<<ss<<"("<<lr<<","<<hr<<")"<<std::endl;
 //            sleep(2);
 
-            found = false;
-            upper_bound(found,lr,hr,[&itera,&pattern,this](const grammar_representation::g_long & a)->int
-            {
-                auto begin = pattern.begin()-1;
-                auto end = itera;
-                auto r =  match_suffix(a,end,begin);
-                if(r == 0 && begin != end) return 1;
+                found = false;
+                upper_bound(found,lr,hr,[&itera,&pattern,this](const grammar_representation::g_long & a)->int
+                {
+                    auto begin = pattern.begin()-1;
+                    auto end = itera;
+                    auto r =  match_suffix(a,end,begin);
+                    if(r == 0 && begin != end) return 1;
 //                if(r == 0 && end != begin) return 1;
 
-                return r;
-            });
-            if(!found)
-                continue;
+                    return r;
+                });
+                if(!found)
+                    continue;
 //            std::cout<<ss<<"("<<lr<<","<<hr<<")"<<std::endl;
 //            sleep(2);
-            binary_relation::bin_long r2 = hr;
+                binary_relation::bin_long r2 = hr;
 
 
-            grammar_representation::g_long ls = 1,hs = n_sj;
+                grammar_representation::g_long ls = 1,hs = n_sj;
 
-            found = false;
-            lower_bound(found, ls,hs,[&itera,&pattern,this](const grammar_representation::g_long & a)->int
-            {
-                auto end = pattern.end();
-                auto begin = itera+1;
-                auto r = dfs_cmp_suffix_grammar(a,begin,end);
-
-                return r;
-            });
+                found = false;
+                lower_bound(found, ls,hs,[&itera,&pattern,this](const grammar_representation::g_long & a)->int
+                {
+                    auto end = pattern.end();
+                    auto begin = itera+1;
+                    auto r = dfs_cmp_suffix_grammar(a,begin,end);
 
-            if(!found)
-                continue;
-            binary_relation::bin_long c1 = ls;
-            hs = n_sj;
+                    return r;
+                });
 
-            found = false;
+                if(!found)
+                    continue;
+                binary_relation::bin_long c1 = ls;
+                hs = n_sj;
 
-            upper_bound(found,ls,hs,[&itera,&pattern,this](const grammar_representation::g_long & a)->int
-            {
-                auto end = pattern.end();
-                auto begin = itera+1;
-                auto r =  dfs_cmp_suffix_grammar(a,begin,end);
-                return r;
-            });
+                found = false;
 
-            if(!found)
-                continue;
+                upper_bound(found,ls,hs,[&itera,&pattern,this](const grammar_representation::g_long & a)->int
+                {
+                    auto end = pattern.end();
+                    auto begin = itera+1;
+                    auto r =  dfs_cmp_suffix_grammar(a,begin,end);
+                    return r;
+                });
+
+                if(!found)
+                    continue;
 //
 //
 
-            binary_relation::bin_long c2 = hs;
+                binary_relation::bin_long c2 = hs;
 ////            std::cout<<r1<<" "<<r2<<" "<<c1<<" "<<c2<<std::endl;
 //
 
 
-            long len = itera-pattern.begin() +1;
+                long len = itera-pattern.begin() +1;
 
 
-            find_second_occ(r1,r2,c1,c2,len,occ);
+                find_second_occ(r1,r2,c1,c2,len,out);
 
 //            const auto& g_tree = _g.get_parser_tree();
 //            std::vector< std::pair<size_t,size_t> > pairs;
@@ -1230,12 +1239,19 @@ public:
 //            }
 //
 
+            }
+
+            if(par)
+            {
+#pragma omp critical
+                occ.insert(occ.end(),t_occ.begin(),t_occ.end());
+            }
         }
 
 
     }
 
-    virtual void qgram_locate_prefix_search( std::string & pattern, std::vector<uint> & occ){
+    virtual void qgram_locate_prefix_search( std::string & pattern, std::vector<index_long> & occ){
 
         if(pattern.size() == 1)
         {
@@ -1428,7 +1444,7 @@ public:
 
     }
 
-    virtual void qgram_trie_locate(std::string & pattern, std::vector<uint> & occ){
+    virtual void qgram_trie_locate(std::string & pattern, std::vector<index_long> & occ){
 
 
         if(pattern.size() == 1)
@@ -1615,7 +1631,7 @@ public:
 
     }
 
-    virtual void qgram_dfs_locate(std::string & pattern, std::vector<uint> & occ){
+    virtual void qgram_dfs_locate(std::string & pattern, std::vector<index_long> & occ){
 
         if(pattern.size() == 1)
         {
@@ -1841,7 +1857,7 @@ public:
         return r;
     }
 
-    void display(const std::size_t& i, const std::size_t& j, std::string & s) override{
+    void display(const std::size_t& i, const std::size_t& j, std::string & s) const override{
 //        s.resize(j - i + 1);
 //        size_t p = 0;
         SelfGrammarIndexBS::display(i,j,s);
@@ -48,15 +48,21 @@ public:
 
     void locate(std::string &, sdsl::bit_vector &) override;
 
-    void locate(std::string &, std::vector<uint> &) override;
+    using SelfGrammarIndex::locate;
+    using SelfGrammarIndex::locateNoTrie;
+    using SelfGrammarIndex::find_ranges;
 
-    void locateNoTrie(std::string &, std::vector<uint> &) override;
+    void locate(std::string_view, std::vector<index_long> &) const override;
 
-    void find_ranges_trie(std::string & s, std::vector<uint> & X) override{};
-    void find_ranges_trie(std::string & s, std::vector<uint> & X, std::vector<range> & f) override{};
-    void find_ranges(std::string & s, std::vector<uint> & X) override{};
-    void find_ranges_dfs(std::string &, std::vector<uint>& ) override{}
-    void display(const std::size_t &, const std::size_t &, std::string &) override;
+    bool split_range(std::string &, const size_t &, range &) const override;
+
+    void locateNoTrie(std::string_view, std::vector<index_long> &) const override;
+
+    void find_ranges_trie(std::string & s, std::vector<index_long> & X) override{};
+    void find_ranges_trie(std::string & s, std::vector<index_long> & X, std::vector<range> & f) override{};
+    void find_ranges(std::string_view s, std::vector<index_long> & X) const override{};
+    void find_ranges_dfs(std::string &, std::vector<index_long>& ) override{}
+    void display(const std::size_t &, const std::size_t &, std::string &) const override;
 
     void save(std::fstream &) override;
 
@@ -5,6 +5,9 @@
 
 #include <sdsl/lcp_bitcompressed.hpp>
 #include <sdsl/rmq_succinct_sada.hpp>
+#include <algorithm>
+#include <unordered_map>
+#include <unordered_set>
 
 #include "SelfGrammarIndexPTS.h"
 
@@ -18,6 +21,8 @@ void SelfGrammarIndexPTS::build(const std::string &text
 
 
 
+    clear_query_structures();
+
     grammar not_compressed_grammar;
     std::vector< std::pair< std::pair<size_t ,size_t >,std::pair<size_t ,size_t > > > grammar_sfx;
     SelfGrammarIndex::build_basics(text,not_compressed_grammar,grammar_sfx
@@ -40,7 +45,7 @@ void SelfGrammarIndexPTS::build(const std::string &text
     {
         m_patricia::patricia_tree<m_patricia::string_pairs> T;
         unsigned long id = 0;
-        for (int i = 0; i < grammar_sfx.size(); i += sampling)
+        for (size_t i = 0; i < grammar_sfx.size(); i += sampling)
         {
             m_patricia::string_pairs s(text,++id);
             s.set_left(grammar_sfx[i].first.first);
@@ -78,7 +83,37 @@ void SelfGrammarIndexPTS::build(const std::string &text
 }
 
 
-void SelfGrammarIndexPTS::locate( std::string & pattern, std::vector<uint> &occ)
+void SelfGrammarIndexPTS::locate( std::string_view p, std::vector<index_long> &occ) const
+{
+    std::string pattern(p);
+    if(cached_result(pattern,occ))
+        return;
+    size_t first = occ.size();
+    query_context ctx;
+    locate_splits(pattern,occ,ctx);
+    cache_result(pattern,occ,first);
+}
+
+bool SelfGrammarIndexPTS::cached_result(const std::string & pattern, std::vector<index_long> & occ) const
+{
+    if(!result_cache.enabled())
+        return false;
+    std::vector<index_long> cached;
+    if(!result_cache.get(pattern,cached))
+        return false;
+    occ.insert(occ.end(),cached.begin(),cached.end());
+    return true;
+}
+
+void SelfGrammarIndexPTS::cache_result(const std::string & pattern, const std::vector<index_long> & occ, const size_t & first) const
+{
+    if(!result_cache.enabled())
+        return;
+    std::vector<index_long> result(occ.begin() + first,occ.end());
+    result_cache.put(pattern,result,pattern.size() + result.size()*sizeof(index_long));
+}
+
+void SelfGrammarIndexPTS::locate_splits( std::string & pattern, std::vector<index_long> &occ, query_context & ctx) const
 {
 
     if(pattern.size() == 1)
@@ -87,275 +122,632 @@ void SelfGrammarIndexPTS::locate( std::string & pattern, std::vector<uint> &occ)
         return;
     }
 
+    const range *b, *e;
+    if(find_short(pattern,b,e))
+    {
+        for (; b != e; ++b) {
+            long len = b->len;
+            if(par_second_occ)
+                find_second_occ_par(b->x1,b->x2,b->y1,b->y2,len,occ);
+            else
+                find_second_occ_dag(b->x1,b->x2,b->y1,b->y2,len,occ,ctx);
+        }
+        return;
+    }
+
     size_t p_n = pattern.size();
-    const auto& g_tree = _g.get_parser_tree();
-    auto nrules = _g.n_rules()-1;
-    auto nsfx = grid.n_columns();
 
+    /*
+     * The threads work inside the splits, they are run one after the other
+     * */
+    if(par_second_occ)
+    {
+        for (size_t i = 1; i <= p_n ; ++i) {
 
-    for (size_t i = 1; i <= p_n ; ++i) {
+            size_t p_r1, p_r2, p_c1, p_c2;
 
-        auto itera = pattern.begin() + i - 1;
-        /*
-         *
-         * Extracting range for rev(p[1...k]) in the rule patricia tree
-         *
-         * */
+            if(!rules_range(pattern, i, p_r1, p_r2, ctx))
+                continue;
 
-        m_patricia::rev_string_pairs sp1(pattern, 1);
-        sp1.set_left(0);
-        sp1.set_right(i - 1);
+            if(!sfx_range(pattern, i, p_c1, p_c2, ctx))
+                continue;
 
-        const auto &rules_t = rules_p_tree.get_tree();
-        auto node_match_rules = rules_p_tree.node_match(sp1);
-        //const auto& rules_leaf = rules_t.leafrank(node_match_rules);
+            auto x1 = (index_long) p_r1, x2 = (index_long) p_r2, y1 = (index_long) p_c1, y2 = (index_long) p_c2;
 
-        size_t p_r2 = nrules, p_r1 = rules_t.leafrank(node_match_rules);
+            long len = i;
 
-        auto begin_r_string = pattern.begin();
-        auto end_r_string = itera;
+            find_second_occ_par(x1,x2,y1,y2,len,occ);
+        }
+        return;
+    }
 
-        auto rcmp_rules = bp_cmp_suffix(_st(p_r1), end_r_string, begin_r_string);
-        auto match_rules = itera - end_r_string;
+    /*
+     * The partitions of the pattern are independent, in the parallel mode (see set_par_locate)
+     * each thread keeps its own occurrences and context and they are merged at the end
+     * */
+    bool par = par_locate && p_n >= par_locate_min;
+#pragma omp parallel if(par)
+    {
+        std::vector<index_long> t_occ;
+        query_context t_ctx;
+        auto& out = par ? t_occ : occ;
+        auto& c = par ? t_ctx : ctx;
 
+#pragma omp for schedule(dynamic) nowait
+        for (size_t i = 1; i <= p_n ; ++i) {
 
-        begin_r_string = pattern.begin();
-        end_r_string = itera;
+            size_t p_r1, p_r2, p_c1, p_c2;
 
-        if (match_rules == sp1.size()) // match_node  == locus_node && all the symbols of pattern are consumed
+            if(!rules_range(pattern, i, p_r1, p_r2, c))
+                continue;
+
+            if(!sfx_range(pattern, i, p_c1, p_c2, c))
+                continue;
+
+            auto x1 = (index_long) p_r1, x2 = (index_long) p_r2, y1 = (index_long) p_c1, y2 = (index_long) p_c2;
+
+            long len = i;
+
+            find_second_occ_dag(x1,x2,y1,y2,len,out,c);
+
+        }
+
+        if(par)
         {
+#pragma omp critical
+            occ.insert(occ.end(),t_occ.begin(),t_occ.end());
+        }
+    }
+}
 
-            p_r2 = p_r1 + rules_t.leafnum(node_match_rules) - 1;
+bool SelfGrammarIndexPTS::locate( std::string_view p, std::vector<index_long> &occ, const size_t & limit) const
+{
+    std::string pattern(p);
+    size_t n_occ = 0;
+    /*
+     * The search stops at the first occurrence after the limit
+     * */
+    auto report = [&occ,&n_occ,&limit](const index_long & pos)->bool{
+        if(n_occ == limit) return false;
+        occ.push_back(pos);
+        ++n_occ;
+        return true;
+    };
+    return !locate(pattern,report);
+}
+
+int SelfGrammarIndexPTS::rules_cmp(std::string & pattern, const size_t & i, const grammar_representation::g_long & a) const
+{
+    auto begin = pattern.begin();
+    auto end = pattern.begin() + i - 1;
+    auto r = bp_cmp_suffix(a,end,begin);
+    if (r == 0 && end != begin - 1) return 1;
+    return r;
+}
+
+int SelfGrammarIndexPTS::sfx_cmp(std::string & pattern, const size_t & i, const size_t & sfx_preorder, const size_t & X) const
+{
+    auto begin = pattern.begin() + i;
+    auto end = pattern.end();
+    return bp_cmp_suffix_grammar(sfx_preorder, X, begin, end);
+}
+
+bool SelfGrammarIndexPTS::rules_range(std::string & pattern, const size_t & i, size_t & p_r1, size_t & p_r2, query_context & ctx) const
+{
+    if(!split_cache.enabled())
+        return search_rules_range(pattern,i,p_r1,p_r2);
+
+    auto& key = ctx.key;
+    key.assign(1,'r').append(pattern,0,i);
+    batch_range r;
+    if(!split_cache.get(key,r))
+    {
+        r.first = search_rules_range(pattern,i,r.second.first,r.second.second);
+        split_cache.put(key,r,1);
+    }
+    p_r1 = r.second.first, p_r2 = r.second.second;
+    return r.first;
+}
+
+bool SelfGrammarIndexPTS::search_rules_range(std::string & pattern, const size_t & i, size_t & p_r1, size_t & p_r2) const
+{
+    bound_search lo, up;
+    rules_range_bounds(pattern, i, lo, up);
+
+    auto cmp = [&pattern,&i,this](const grammar_representation::g_long & a)->int{
+        return rules_cmp(pattern,i,a);
+    };
+
+    lower_bound(lo.found, lo.lr, lo.hr, cmp);
+    if(!lo.found)
+        return false;
+
+    p_r1 = lo.lr;
+    if(up.chained)
+        up.lr = lo.lr;
+
+    upper_bound(up.found, up.lr, up.hr, cmp);
+    if(!up.found)
+        return false;
+
+    p_r2 = up.hr;
+    return true;
+}
+
+void SelfGrammarIndexPTS::rules_range_bounds(std::string & pattern, const size_t & i, bound_search & lo, bound_search & up) const
+{
+    auto nrules = _g.n_rules()-1;
+    auto itera = pattern.begin() + i - 1;
+    /*
+     *
+     * Extracting range for rev(p[1...k]) in the rule patricia tree
+     *
+     * */
+
+    m_patricia::rev_string_pairs sp1(pattern, 1);
+    sp1.set_left(0);
+    sp1.set_right(i - 1);
+
+    const auto &rules_t = rules_p_tree.get_tree();
+    auto node_match_rules = rules_p_tree.node_match(sp1);
+
+    size_t p_r1 = rules_t.leafrank(node_match_rules);
+
+    auto begin_r_string = pattern.begin();
+    auto end_r_string = itera;
+
+    auto rcmp_rules = bp_cmp_suffix(_st(p_r1), end_r_string, begin_r_string);
+    auto match_rules = itera - end_r_string;
+
+    lo.upper = false;
+    up.upper = true;
+
+    if (match_rules == sp1.size()) // match_node  == locus_node && all the symbols of pattern are consumed
+    {
+        size_t p_r2 = p_r1 + rules_t.leafnum(node_match_rules) - 1;
+        // sampled rules corresponding to leaves.
+        size_t ii = _st(p_r1), jj = _st(p_r2);
+        // new range of search
+        size_t ii_low = (ii == 1) ? 1 : ii - sampling;
+        size_t jj_hight = (jj + sampling <= nrules) ? jj + sampling : nrules;
+
+        lo.lr = ii_low, lo.hr = ii;
+        //BINARY SEARCH ON THE INTERVAL FOR UPPER BOUND
+        up.lr = jj, up.hr = jj_hight;
+        up.chained = false;
+
+    } else  // if all the symbols of the patterns were not consumed
+    {
+        unsigned int pos_locus = 0;
+        auto locus_node_rules = rules_p_tree.node_locus(sp1, match_rules, pos_locus);
+        // find the left most leaf in the real range
+        size_t ii, jj;
+        if (rules_t.isleaf(locus_node_rules)) {
+            p_r1 = rules_t.leafrank(node_match_rules);
+            ii = (p_r1 == 1) ? 1 : p_r1 - 1;
+            ii = _st(ii), jj = ii + ((p_r1 == 1) ? sampling : 2 * sampling);
+        } else {
+            p_r1 = rules_p_tree.find_child_range(locus_node_rules, sp1, pos_locus, rcmp_rules);
             // sampled rules corresponding to leaves.
-            size_t ii = _st(p_r1), jj = _st(p_r2);
-            // new range of search
-            size_t ii_low = (ii == 1) ? 1 : ii - sampling;
-            size_t jj_hight = (jj + sampling <= nrules) ? jj + sampling : nrules;
+            ii = _st(p_r1), jj = ii + sampling;
 
-            grammar_representation::g_long lb = ii_low, ub = ii;
-            bool found = false;
-            lower_bound(found,lb, ub, [&begin_r_string,&end_r_string, this](const grammar_representation::g_long &a) -> int {
-                auto begin = begin_r_string;
-                auto end = end_r_string;
-                auto r = bp_cmp_suffix(a,end,begin);
-                if (r == 0 && end != begin - 1) return 1;
-                return r;
-            });
-            if(!found)
-                continue;
+        }
 
-            p_r1 = lb;
+        jj = (jj < nrules) ? jj : nrules;
 
-            lb = jj, ub = jj_hight;
-            //BINARY SEARCH ON THE INTERVAL FOR UPPER BOUND
+        lo.lr = ii, lo.hr = jj;
+        // the upper bound is searched from the lower bound
+        up.lr = ii, up.hr = jj;
+        up.chained = true;
+    }
+}
 
-            found = false;
-            upper_bound(found,lb,ub,[&begin_r_string,&end_r_string,this](const grammar_representation::g_long & a)->int
-            {
-                auto begin = begin_r_string;
-                auto end = end_r_string;
-                auto r =  bp_cmp_suffix(a,end,begin);
-                if (r == 0 && end != begin - 1) return 1;
-                return r;
-            });
-            if(!found)
-                continue;
+bool SelfGrammarIndexPTS::sfx_range(std::string & pattern, const size_t & i, size_t & p_c1, size_t & p_c2, query_context & ctx) const
+{
+    if(!split_cache.enabled())
+        return search_sfx_range(pattern,i,p_c1,p_c2);
 
-            p_r2 = ub;
+    auto& key = ctx.key;
+    key.assign(1,'s').append(pattern,i,std::string::npos);
+    batch_range c;
+    if(!split_cache.get(key,c))
+    {
+        c.first = search_sfx_range(pattern,i,c.second.first,c.second.second);
+        split_cache.put(key,c,1);
+    }
+    p_c1 = c.second.first, p_c2 = c.second.second;
+    return c.first;
+}
 
-            // sampling_range_rules(p_r1,p_r2,begin_r_string,end_r_string);
+bool SelfGrammarIndexPTS::search_sfx_range(std::string & pattern, const size_t & i, size_t & p_c1, size_t & p_c2) const
+{
+    bound_search lo, up;
+    sfx_range_bounds(pattern, i, lo, up);
 
-        } else  // if all the symbols of the patterns were not consumed
-        {
-            unsigned int pos_locus = 0;
-            auto locus_node_rules = rules_p_tree.node_locus(sp1, match_rules, pos_locus);
-            // find the left most leaf in the real range
-            size_t ii, jj;
-            if (rules_t.isleaf(locus_node_rules)) {
-                p_r1 = rules_t.leafrank(node_match_rules);
-                ii = (p_r1 == 1) ? 1 : p_r1 - 1;
-                ii = _st(ii), jj = ii + ((p_r1 == 1) ? sampling : 2 * sampling);
-            } else {
-                p_r1 = rules_p_tree.find_child_range(locus_node_rules, sp1, pos_locus, rcmp_rules);
-                // sampled rules corresponding to leaves.
-                ii = _st(p_r1), jj = ii + sampling;
+    auto cmp = [&pattern,&i,this](const grammar_representation::g_long & a)->int{
+        auto begin = pattern.begin() + i;
+        auto end = pattern.end();
+        return bp_cmp_suffix_grammar(a, begin, end);
+    };
 
-            }
+    lower_bound(lo.found, lo.lr, lo.hr, cmp);
+    if(!lo.found)
+        return false;
 
-            jj = (jj < nrules) ? jj : nrules;
+    p_c1 = lo.lr;
+    if(up.chained)
+        up.lr = lo.lr;
 
+    upper_bound(up.found, up.lr, up.hr, cmp);
+    if(!up.found)
+        return false;
 
+    p_c2 = up.hr;
+    return true;
+}
 
+void SelfGrammarIndexPTS::sfx_range_bounds(std::string & pattern, const size_t & i, bound_search & lo, bound_search & up) const
+{
+    auto nsfx = grid.n_columns();
+    auto itera = pattern.begin() + i - 1;
 
-            ///////////////////////////////////////////////////
-            grammar_representation::g_long lb = ii, ub = jj;
-            bool found = false;
-            lower_bound(found,lb, ub, [&begin_r_string,&end_r_string, this](const grammar_representation::g_long &a) -> int {
-                auto begin = begin_r_string;
-                auto end = end_r_string;
-                auto r = bp_cmp_suffix(a,end,begin);
-                if (r == 0 && end != begin - 1) return 1;
-                return r;
-            });
-            if(!found)
-                continue;
+    m_patricia::string_pairs sp2(pattern, 2);
+    sp2.set_left(i);
+    sp2.set_right(pattern.size() - 1);
 
-            p_r1 = lb;
-            ub = jj;
+    const auto &suff_t = sfx_p_tree.get_tree();
+    auto node_match_suff = sfx_p_tree.node_match(sp2);
 
-            found = false;
-            upper_bound(found,lb,ub,[&begin_r_string,&end_r_string,this](const grammar_representation::g_long & a)->int
-            {
-                auto begin = begin_r_string;
-                auto end = end_r_string;
-                auto r =  bp_cmp_suffix(a,end,begin);
-                if (r == 0 && end != begin - 1) return 1;
-                return r;
-            });
-            if(!found)
-                continue;
+    size_t p_c1 = suff_t.leafrank(node_match_suff);
 
-            p_r2 = ub;
+    auto begin_sfx_string = itera + 1;
+    auto end_sfx_string = pattern.end();
+
+    auto rcmp_sfx = bp_cmp_suffix_grammar(_st(p_c1), begin_sfx_string, end_sfx_string);
+    auto match = begin_sfx_string - itera - 1;
+
+    lo.upper = false;
+    up.upper = true;
+
+    if (match == sp2.size())// match_node  == locus_node && all the symbols of pattern are consumed
+    {
+        size_t p_c2 = p_c1 + suff_t.leafnum(node_match_suff) - 1;
+        // sampled suffix corresponding to leaves.
+        size_t ii = _st(p_c1), jj = _st(p_c2);
+        // new range of search
+        size_t ii_low = (ii == 1) ? 1 : ii - sampling;
+        size_t jj_hight = (jj + sampling <= nsfx) ? jj + sampling : nsfx;
+
+        lo.lr = ii_low, lo.hr = ii;
+        //BINARY SEARCH ON THE INTERVAL FOR UPPER BOUND
+        up.lr = jj, up.hr = jj_hight;
+        up.chained = false;
+
+    } else {// if all the symbols of the patterns are not consumed
+
+
+        unsigned int pos_locus;
+        auto locus_node_suff = sfx_p_tree.node_locus(sp2, match,pos_locus);
+
+        size_t ii, jj;
+
+        if (suff_t.isleaf(locus_node_suff)) {
+
+            p_c1 = suff_t.leafrank(locus_node_suff);
+            ii = (p_c1 == 1) ? 1 : p_c1 - 1;
+            ii = _st(ii), jj = ii + ((p_c1 == 1) ? sampling : 2 * sampling);
 
 
+        } else {
+            // find the left most leaf in the real range
+            p_c1 = sfx_p_tree.find_child_range(locus_node_suff, sp2, pos_locus, rcmp_sfx);
+            ii = _st(p_c1), jj = ii + sampling;
+
         }
+        jj = (jj < nsfx) ? jj : nsfx;
 
-        /*
-         *
-         * Extracting range for (p[k...m]) in the suffix patricia tree
-         *
-         * */
-        //start = timer::now();
-        m_patricia::string_pairs sp2(pattern, 2);
-        sp2.set_left(i);
-        sp2.set_right(pattern.size() - 1);
+        lo.lr = ii, lo.hr = jj;
+        // the upper bound is searched from the lower bound
+        up.lr = ii, up.hr = jj;
+        up.chained = true;
+    }
+}
 
-        const auto &suff_t = sfx_p_tree.get_tree();
-        auto node_match_suff = sfx_p_tree.node_match(sp2);
-        //const auto& suff_leaf = suff_t.leafrank(node_match_suff);
+void SelfGrammarIndexPTS::batch_ranges(std::vector<std::pair<std::string*,size_t>> & Q, const bool & rules, std::vector<batch_range> & R, query_context & ctx) const
+{
+    size_t n = Q.size();
+    std::vector<bound_search> lo(n), up(n);
+    for (size_t k = 0; k < n; ++k) {
+        if(rules)
+            rules_range_bounds(*Q[k].first, Q[k].second, lo[k], up[k]);
+        else
+            sfx_range_bounds(*Q[k].first, Q[k].second, lo[k], up[k]);
+    }
 
-        size_t p_c2 = nsfx, p_c1 = suff_t.leafrank(node_match_suff);
+    /*
+     * The probe of a suffix is split in two steps: the prefetch step finds its first node and rule
+     * (the select on the grid and the access to X_p) and prefetches the q-gram word of the rule,
+     * the comparison starts from them
+     * */
+    std::vector<size_t> ids, pre(n), X(n);
+    auto run = [&](std::vector<bound_search> & S){
+        if(rules)
+            batch_bound(S,[&](const size_t & k, const grammar_representation::g_long & a)->int{
+                return rules_cmp(*Q[ids[k]].first, Q[ids[k]].second, a);
+            },[&](const size_t &, const grammar_representation::g_long & a){
+                prefetch_rule_suffix(a);
+            },ctx);
+        else
+            batch_bound(S,[&](const size_t & k, const grammar_representation::g_long &)->int{
+                return sfx_cmp(*Q[ids[k]].first, Q[ids[k]].second, pre[k], X[k]);
+            },[&](const size_t & k, const grammar_representation::g_long & a){
+                pre[k] = grid.first_label_col(a);
+                X[k] = _g[pre[k]];
+                prefetch_rule_prefix(X[k]);
+            },ctx);
+    };
+
+    for (size_t k = 0; k < n; ++k) ids.push_back(k);
+    run(lo);
 
-        auto begin_sfx_string = itera + 1;
-        auto end_sfx_string = pattern.end();
+    /*
+     * The upper bounds of the non empty ranges
+     * */
+    ids.clear();
+    std::vector<bound_search> U;
+    for (size_t k = 0; k < n; ++k) {
+        if(!lo[k].found)
+            continue;
+        if(up[k].chained)
+            up[k].lr = lo[k].lr;
+        ids.push_back(k);
+        U.push_back(up[k]);
+    }
+    run(U);
+
+    R.assign(n,batch_range(false,std::make_pair(0,0)));
+    for (size_t j = 0; j < ids.size(); ++j) {
+        size_t k = ids[j];
+        R[k].first = U[j].found;
+        R[k].second.first = lo[k].lr;
+        R[k].second.second = U[j].hr;
+    }
+}
 
-        auto rcmp_sfx = bp_cmp_suffix_grammar(_st(p_c1), begin_sfx_string, end_sfx_string);
-        auto match = begin_sfx_string - itera - 1;
+size_t SelfGrammarIndexPTS::count(const std::string & p)
+{
+    query_context ctx;
+    return count(std::string_view(p),ctx);
+}
 
+void SelfGrammarIndexPTS::locate(std::string_view p, std::vector<index_long> & occ, query_context & ctx) const
+{
+    ctx.pattern.assign(p.begin(),p.end());
+    if(cached_result(ctx.pattern,occ))
+        return;
+    size_t first = occ.size();
+    locate(ctx.pattern,[&occ](const index_long & pos)->bool{
+        occ.push_back(pos);
+        return true;
+    },ctx);
+    cache_result(ctx.pattern,occ,first);
+}
 
-        begin_sfx_string = itera + 1;
-        end_sfx_string = pattern.end();
+size_t SelfGrammarIndexPTS::count(std::string_view p, query_context & ctx) const
+{
+    ctx.pattern.assign(p.begin(),p.end());
+    auto& pattern = ctx.pattern;
+    size_t n_occ = 0;
 
-        if (match == sp2.size())// match_node  == locus_node && all the symbols of pattern are consumed
-        {
-            p_c2 = p_c1 + suff_t.leafnum(node_match_suff) - 1;
-            // sampled suffix corresponding to leaves.
-            size_t ii = _st(p_c1), jj = _st(p_c2);
-            // new range of search
-            size_t ii_low = (ii == 1) ? 1 : ii - sampling;
-            size_t jj_hight = (jj + sampling <= nsfx) ? jj + sampling : nsfx;
+    /*
+     * Without the weights of the grid (see build_count) the occurrences are enumerated
+     * */
+    if(pattern.size() == 1 || !grid.has_weights())
+    {
+        locate(pattern,[&n_occ](const index_long &)->bool{
+            ++n_occ;
+            return true;
+        },ctx);
+        return n_occ;
+    }
 
-            //////////////////////////////////////////////
+    const range *b, *e;
+    if(find_short(pattern,b,e))
+    {
+        for (; b != e; ++b) {
+            binary_relation::bin_long x1 = b->x1, x2 = b->x2, y1 = b->y1, y2 = b->y2;
+            n_occ += grid.range_weight(x1,x2,y1,y2);
+        }
+        return n_occ;
+    }
 
-             grammar_representation::g_long lb = ii_low, ub = ii;
-             bool found = false;
-            lower_bound(found,lb, ub, [&begin_sfx_string,&end_sfx_string, this](const grammar_representation::g_long &a) -> int {
-                auto begin = begin_sfx_string;
-                auto end = end_sfx_string;
-                auto r = bp_cmp_suffix_grammar(a, begin, end);
-                return r;
-            });
-             if(!found)
-                continue;
+    size_t p_n = pattern.size();
+    for (size_t i = 1; i <= p_n ; ++i) {
 
-             p_c1 = lb;
+        size_t p_r1, p_r2, p_c1, p_c2;
 
-             lb = jj, ub = jj_hight;
-             //BINARY SEARCH ON THE INTERVAL FOR UPPER BOUND
+        if(!rules_range(pattern, i, p_r1, p_r2, ctx))
+            continue;
 
-            found = false;
-            upper_bound(found,lb,ub,[&begin_sfx_string,&end_sfx_string,this](const grammar_representation::g_long & a)->int
-            {
-                auto begin = begin_sfx_string;
-                auto end = end_sfx_string;
+        if(!sfx_range(pattern, i, p_c1, p_c2, ctx))
+            continue;
 
-                auto r =  bp_cmp_suffix_grammar(a,begin,end);
-                return r;
-            });
-            if(!found)
-                continue;
+        auto x1 = (binary_relation::bin_long) p_r1, x2 = (binary_relation::bin_long) p_r2;
+        auto y1 = (binary_relation::bin_long) p_c1, y2 = (binary_relation::bin_long) p_c2;
 
-             p_c2 = ub;
+        n_occ += grid.range_weight(x1,x2,y1,y2);
+    }
 
-        } else {// if all the symbols of the patterns are not consumed
+    return n_occ;
+}
 
+void SelfGrammarIndexPTS::locate_batch(const std::vector<std::string> & patterns, std::vector<std::vector<index_long>> & occs)
+{
+    occs.clear();
+    occs.resize(patterns.size());
+    query_context ctx; // shared by all the patterns of the batch
 
-            unsigned int pos_locus;
-            auto locus_node_suff = sfx_p_tree.node_locus(sp2, match,pos_locus);
+    /*
+     * Sorting the patterns puts together the equal ones and the ones sharing prefixes,
+     * the ranges of every distinct p[1..i] and p[i+1..m] are searched only once
+     * */
+    std::vector<size_t> order(patterns.size());
+    for (size_t k = 0; k < order.size(); ++k) order[k] = k;
+    std::sort(order.begin(),order.end(),[&patterns](const size_t& a, const size_t& b)->bool{
+        return patterns[a] < patterns[b];
+    });
 
-            size_t ii, jj;
+    std::vector<std::string> P; // distinct patterns longer than one symbol
+    std::vector<size_t> P_id;   // their position in patterns
+    P.reserve(patterns.size());
 
-            if (suff_t.isleaf(locus_node_suff)) {
+    for (size_t k = 0; k < order.size(); ++k) {
 
-                p_c1 = suff_t.leafrank(locus_node_suff);
-                ii = (p_c1 == 1) ? 1 : p_c1 - 1;
-                ii = _st(ii), jj = ii + ((p_c1 == 1) ? sampling : 2 * sampling);
+        const size_t& id = order[k];
 
+        if(k > 0 && patterns[order[k-1]] == patterns[id])
+            continue;
 
-            } else {
-                // find the left most leaf in the real range
-                p_c1 = sfx_p_tree.find_child_range(locus_node_suff, sp2, pos_locus, rcmp_sfx);
-                ii = _st(p_c1), jj = ii + sampling;
+        if(patterns[id].size() == 1)
+        {
+            locate_ch(patterns[id][0],occs[id]);
+            continue;
+        }
 
+        const range *b, *e;
+        if(find_short(patterns[id],b,e))
+        {
+            for (; b != e; ++b) {
+                long len = b->len;
+                find_second_occ_dag(b->x1,b->x2,b->y1,b->y2,len,occs[id],ctx);
             }
-            jj = (jj < nsfx) ? jj : nsfx;
-
+            continue;
+        }
 
-             ///////////////////////////////////////////////////
+        if(cached_result(patterns[id],occs[id]))
+            continue;
 
+        P.push_back(patterns[id]);
+        P_id.push_back(id);
+    }
 
-            grammar_representation::g_long lb = ii, ub = jj;
-            bool found = false;
-            lower_bound(found,lb, ub, [&begin_sfx_string,&end_sfx_string, this](const grammar_representation::g_long &a) -> int {
-                auto begin = begin_sfx_string;
-                auto end = end_sfx_string;
+    /*
+     * The split i of P[k] is the slot off[k] + i - 1 of pfx/sfx, the index of the range of p[1..i]
+     * in rules_ranges and of p[i+1..m] in sfx_ranges. The distinct pieces are found with views
+     * into P (no copies): P is sorted, so p[1..i] is the one of P[k-1] when i is at most their
+     * longest common prefix, the suffixes are deduplicated by a hash table of views
+     * */
+    std::vector<size_t> off(P.size()+1,0);
+    for (size_t k = 0; k < P.size(); ++k)
+        off[k+1] = off[k] + P[k].size();
+    std::vector<size_t> pfx(off.back()), sfx(off.back());
+    std::vector<batch_range> rules_ranges, sfx_ranges;
+    std::unordered_map<std::string_view, size_t> sfx_slot;
+    sfx_slot.reserve(off.back());
 
-                auto r =  bp_cmp_suffix_grammar(a,begin,end);
-                return r;
-            });
-            if(!found)
+    /*
+     * The binary searches of the ranges of every distinct p[1..i] run together (see batch_ranges),
+     * then the ones of p[i+1..m] for the splits with a non empty range of rules
+     * */
+    std::vector<std::pair<std::string*,size_t>> Q;
+    std::vector<size_t> slots;
+    std::vector<batch_range> R;
+    std::string key;
+
+    for (size_t k = 0; k < P.size(); ++k) {
+        size_t lcp = 0;
+        if(k > 0)
+            while(lcp < P[k-1].size() && lcp < P[k].size() && P[k-1][lcp] == P[k][lcp])
+                ++lcp;
+        for (size_t i = 1; i <= P[k].size(); ++i) {
+            if(i <= lcp)
+            {
+                pfx[off[k]+i-1] = pfx[off[k-1]+i-1];
                 continue;
+            }
+            pfx[off[k]+i-1] = rules_ranges.size();
+            rules_ranges.emplace_back();
+            if(split_cache.enabled())
+            {
+                key.assign(1,'r').append(P[k],0,i);
+                if(split_cache.get(key,rules_ranges.back()))
+                    continue;
+            }
+            Q.emplace_back(&P[k],i);
+            slots.push_back(rules_ranges.size()-1);
+        }
+    }
+    batch_ranges(Q,true,R,ctx);
+    for (size_t q = 0; q < Q.size(); ++q) {
+        rules_ranges[slots[q]] = R[q];
+        if(split_cache.enabled())
+            split_cache.put(key.assign(1,'r').append(*Q[q].first,0,Q[q].second),R[q],1);
+    }
 
-            p_c1 = lb;
-            ub = jj;
-            found = false;
-            upper_bound(found,lb,ub,[&begin_sfx_string,&end_sfx_string,this](const grammar_representation::g_long & a)->int
+    Q.clear();
+    slots.clear();
+    for (size_t k = 0; k < P.size(); ++k)
+        for (size_t i = 1; i <= P[k].size(); ++i) {
+            if(!rules_ranges[pfx[off[k]+i-1]].first)
+                continue;
+            auto it = sfx_slot.emplace(std::string_view(P[k]).substr(i),sfx_ranges.size());
+            sfx[off[k]+i-1] = it.first->second;
+            if(!it.second)
+                continue;
+            sfx_ranges.emplace_back();
+            if(split_cache.enabled())
             {
-                auto begin = begin_sfx_string;
-                auto end = end_sfx_string;
-                auto r = bp_cmp_suffix_grammar(a, begin, end);
-                return r;
-            });
-            if(!found) continue;
+                key.assign(1,'s').append(P[k],i,std::string::npos);
+                if(split_cache.get(key,sfx_ranges.back()))
+                    continue;
+            }
+            Q.emplace_back(&P[k],i);
+            slots.push_back(sfx_ranges.size()-1);
+        }
+    batch_ranges(Q,false,R,ctx);
+    for (size_t q = 0; q < Q.size(); ++q) {
+        sfx_ranges[slots[q]] = R[q];
+        if(split_cache.enabled())
+            split_cache.put(key.assign(1,'s').append(*Q[q].first,Q[q].second,std::string::npos),R[q],1);
+    }
 
-            p_c2 = ub;
+    for (size_t k = 0; k < P.size(); ++k) {
 
-        }
+        const auto& pattern = P[k];
 
-        auto x1 = (uint) p_r1, x2 = (uint) p_r2, y1 = (uint) p_c1, y2 = (uint) p_c2;
+        for (size_t i = 1; i <= pattern.size() ; ++i) {
 
+            const auto& r = rules_ranges[pfx[off[k]+i-1]];
+            if(!r.first)
+                continue;
 
-        long len = itera-pattern.begin() +1;
+            const auto& c = sfx_ranges[sfx[off[k]+i-1]];
+            if(!c.first)
+                continue;
 
+            auto x1 = (index_long) r.second.first, x2 = (index_long) r.second.second;
+            auto y1 = (index_long) c.second.first, y2 = (index_long) c.second.second;
 
-        find_second_occ(x1,x2,y1,y2,len,occ);
+            long len = i;
+
+            find_second_occ_dag(x1,x2,y1,y2,len,occs[P_id[k]],ctx);
+        }
 
+        cache_result(pattern,occs[P_id[k]],0);
     }
+
+    /*
+     * The repeated patterns copy the occurrences of the first one
+     * */
+    for (size_t k = 1; k < order.size(); ++k)
+        if(patterns[order[k-1]] == patterns[order[k]])
+            occs[order[k]] = occs[order[k-1]];
 }
 
 
-void SelfGrammarIndexPTS::locateNoTrie( std::string & pattern, std::vector<uint> &occ)
+void SelfGrammarIndexPTS::locateNoTrie( std::string_view p, std::vector<index_long> &occ) const
 {
+    std::string pattern(p);
 
     if(pattern.size() == 1)
     {
@@ -620,7 +1012,7 @@ void SelfGrammarIndexPTS::locateNoTrie( std::string & pattern, std::vector<uint>
         }
 
 //        std::vector<std::pair<size_t, size_t> > pairs;
-        auto x1 = (uint) p_r1, x2 = (uint) p_r2, y1 = (uint) p_c1, y2 = (uint) p_c2;
+        auto x1 = (index_long) p_r1, x2 = (index_long) p_r2, y1 = (index_long) p_c1, y2 = (index_long) p_c2;
 
 
         long len = itera-pattern.begin() +1;
@@ -649,7 +1041,7 @@ void SelfGrammarIndexPTS::locateNoTrie( std::string & pattern, std::vector<uint>
 }
 
 
-void SelfGrammarIndexPTS::locate2( std::string & pattern, std::vector<uint> &occ)
+void SelfGrammarIndexPTS::locate2( std::string & pattern, std::vector<index_long> &occ)
 {
 
     if(pattern.size() == 1)
@@ -758,7 +1150,7 @@ void SelfGrammarIndexPTS::locate2( std::string & pattern, std::vector<uint> &occ
             continue;
 
         std::vector< std::pair<size_t,size_t> > pairs;
-        auto  x1 = (uint)p_r1,x2 = (uint)p_r2,y1 = (uint)p_c1,y2 = (uint)p_c2;
+        auto  x1 = (index_long)p_r1,x2 = (index_long)p_r2,y1 = (index_long)p_c1,y2 = (index_long)p_c2;
         long len = itera-pattern.begin() +1;
         find_second_occ(x1,x2,y1,y2,len,occ);
     }
@@ -776,6 +1168,14 @@ void SelfGrammarIndexPTS::load(std::fstream & f_in)
     f_in >> sampling;
 }
 
+void SelfGrammarIndexPTS::clear_query_structures()
+{
+    SelfGrammarIndexPT::clear_query_structures();
+    build_short_ranges(0);
+    split_cache.clear();
+    result_cache.clear();
+}
+
 void SelfGrammarIndexPTS::sampling_range_rules(size_t &i, size_t &j,std::string::iterator& iterator1, std::string::iterator& iterator2) const
 {
 
@@ -864,10 +1264,12 @@ size_t SelfGrammarIndexPTS::size_in_bytes() const
 {
 //    std::cout<<"SelfGrammarIndexPTS::size_in_bytes()\n";
 
-    return SelfGrammarIndexPT::size_in_bytes() + sizeof(sampling);
+    return SelfGrammarIndexPT::size_in_bytes() + sizeof(sampling) + short_ranges.size()*sizeof(range) +
+           short_patterns.size()*(sizeof(uint64_t) + sizeof(std::pair<uint32_t,uint32_t>) + sizeof(void*)) +
+           short_patterns.bucket_count()*sizeof(void*);
 }
 
-void SelfGrammarIndexPTS::display(const std::size_t &i, const std::size_t &j, std::string &s)
+void SelfGrammarIndexPTS::display(const std::size_t &i, const std::size_t &j, std::string &s) const
 {
     SelfGrammarIndexPT::display( i,j,s);
 }
@@ -877,6 +1279,122 @@ size_t SelfGrammarIndexPTS::_st(const size_t & i)const
     return  (i-1)*sampling + 1;
 }
 
+uint64_t SelfGrammarIndexPTS::short_key(const char * p, const size_t & m)
+{
+    uint64_t w = 0;
+    for (size_t k = 0; k < m; ++k)
+        w |= ((uint64_t)(unsigned char)p[k]) << (8*(7-k));
+    return w | m;
+}
+
+bool SelfGrammarIndexPTS::find_short(const std::string & pattern, const range *& b, const range *& e) const
+{
+    if(pattern.size() < 2 || pattern.size() > short_q)
+        return false;
+    b = e = nullptr;
+    auto it = short_patterns.find(short_key(pattern.data(),pattern.size()));
+    if(it != short_patterns.end())
+    {
+        b = short_ranges.data() + it->second.first;
+        e = short_ranges.data() + it->second.second;
+    }
+    return true;
+}
+
+void SelfGrammarIndexPTS::split_ranges(std::string & pattern, std::vector<range> & R) const
+{
+    R.clear();
+
+    const range *b, *e;
+    if(find_short(pattern,b,e))
+    {
+        R.insert(R.end(),b,e);
+        return;
+    }
+
+    for (size_t i = 1; i <= pattern.size() ; ++i) {
+        range r;
+        if(split_range(pattern, i, r))
+            R.push_back(r);
+    }
+}
+
+bool SelfGrammarIndexPTS::split_range(std::string & pattern, const size_t & i, range & r) const
+{
+    size_t p_r1, p_r2, p_c1, p_c2;
+    query_context ctx;
+
+    if(!rules_range(pattern, i, p_r1, p_r2, ctx))
+        return false;
+
+    if(!sfx_range(pattern, i, p_c1, p_c2, ctx))
+        return false;
+
+    r.x1 = (index_long) p_r1, r.x2 = (index_long) p_r2, r.y1 = (index_long) p_c1, r.y2 = (index_long) p_c2;
+    r.len = (index_long) i;
+    return true;
+}
+
+void SelfGrammarIndexPTS::build_short_ranges(const size_t & q)
+{
+    short_patterns.clear();
+    short_ranges.clear();
+    short_q = (q < 7)? q : 7;
+    if(short_q < 2)
+    {
+        short_q = 0;
+        return;
+    }
+
+    /*
+     * Distinct substrings of 2 to short_q symbols of the text, extracted by chunks
+     * (overlapping in short_q - 1 symbols)
+     * */
+    std::unordered_set<uint64_t> keys;
+    size_t n = _g.get_size_text();
+    const size_t chunk = 1 << 20;
+    std::string s;
+    query_context ctx;
+    for (size_t i = 0; i < n; i += chunk)
+    {
+        size_t j = std::min(i + chunk + short_q - 1, n) - 1;
+        display(i,j,s,ctx);
+        for (size_t k = 0; k < chunk && k < s.size(); ++k)
+            for (size_t m = 2; m <= short_q && k + m <= s.size(); ++m)
+                keys.insert(short_key(s.data() + k,m));
+    }
+
+    std::vector<uint64_t> sorted_keys(keys.begin(),keys.end());
+    std::sort(sorted_keys.begin(),sorted_keys.end());
+
+    std::string pattern;
+    for (auto &&key : sorted_keys)
+    {
+        size_t m = key & 0xFF;
+        pattern.resize(m);
+        for (size_t k = 0; k < m; ++k)
+            pattern[k] = (char)(key >> (8*(7-k)));
+
+        auto b = (uint32_t)short_ranges.size();
+        for (size_t i = 1; i <= m ; ++i) {
+
+            size_t p_r1, p_r2, p_c1, p_c2;
+
+            if(!rules_range(pattern, i, p_r1, p_r2, ctx))
+                continue;
+
+            if(!sfx_range(pattern, i, p_c1, p_c2, ctx))
+                continue;
+
+            range r;
+            r.x1 = (index_long) p_r1, r.x2 = (index_long) p_r2, r.y1 = (index_long) p_c1, r.y2 = (index_long) p_c2;
+            r.len = (index_long) i;
+            short_ranges.push_back(r);
+        }
+        short_patterns[key] = std::make_pair(b,(uint32_t)short_ranges.size());
+    }
+}
+
 SelfGrammarIndexPTS::SelfGrammarIndexPTS(const int & s):SelfGrammarIndexPT()
 {
     sampling = s;
@@ -891,6 +1409,7 @@ SelfGrammarIndexPTS::build(const SelfGrammarIndex::grammar_representation &G, co
                            const unsigned int & s) {
     SelfGrammarIndexPT::build(G, R, sfx, rules);
     sampling = (int)s;
+    clear_query_structures();
 }
 
 void SelfGrammarIndexPTS::build_suffix(const string & text, fstream &suffixes, fstream &repair_g
@@ -900,6 +1419,7 @@ void SelfGrammarIndexPTS::build_suffix(const string & text, fstream &suffixes, f
 #endif
 ) {
 
+    clear_query_structures();
 
     grammar not_compressed_grammar;
     not_compressed_grammar.load(repair_g);
@@ -929,7 +1449,7 @@ void SelfGrammarIndexPTS::build_suffix(const string & text, fstream &suffixes, f
     {
         m_patricia::patricia_tree<m_patricia::string_pairs> T;
         unsigned long id = 0;
-        for (int i = 0; i < grammar_sfx.size(); i += sampling)
+        for (size_t i = 0; i < grammar_sfx.size(); i += sampling)
         {
             m_patricia::string_pairs s(text,++id);
             s.set_left(grammar_sfx[i].first.first);
@@ -979,7 +1499,8 @@ void SelfGrammarIndexPTS::build_suffix(const string & text, fstream &suffixes, f
 
 
 
-void SelfGrammarIndexPTS::find_ranges(std::string & pattern, std::vector<uint> & X) {
+void SelfGrammarIndexPTS::find_ranges(std::string_view p, std::vector<index_long> & X) const {
+    std::string pattern(p);
     size_t p_n = pattern.size();
     const auto &g_tree = _g.get_parser_tree();
     auto nrules = _g.n_rules() - 1;
@@ -1282,7 +1803,7 @@ void SelfGrammarIndexPTS::find_ranges(std::string & pattern, std::vector<uint> &
     }
 }
 
-void SelfGrammarIndexPTS::find_ranges_trie(std::string & pattern, std::vector<uint> & X) {
+void SelfGrammarIndexPTS::find_ranges_trie(std::string & pattern, std::vector<index_long> & X) {
 
 
     size_t p_n = pattern.size();
@@ -1576,7 +2097,7 @@ void SelfGrammarIndexPTS::find_ranges_trie(std::string & pattern, std::vector<ui
 
 
 
-void SelfGrammarIndexPTS::find_ranges_trie(std::string & pattern, std::vector<uint> & X, std::vector<range> & fr) {
+void SelfGrammarIndexPTS::find_ranges_trie(std::string & pattern, std::vector<index_long> & X, std::vector<range> & fr) {
 
 
     size_t p_n = pattern.size();
@@ -9,6 +9,9 @@
 
 #include "SelfGrammarIndexPT.h"
 #include <ctime>
+#include <string_view>
+#include <unordered_map>
+#include "utils/query_cache.h"
 
 
 
@@ -17,6 +20,23 @@ class SelfGrammarIndexPTS:public SelfGrammarIndexPT{
     protected:
 
     int sampling;
+    /*
+     * Optional search ranges of the patterns of 2 to short_q symbols that occur in the text
+     * (see build_short_ranges). The key of a pattern packs its symbols from the most significant
+     * byte and its length in the last one, its ranges (one per split with points in the grid)
+     * are short_ranges[b..e)
+     * */
+    size_t short_q{0};
+    std::unordered_map<uint64_t, std::pair<uint32_t,uint32_t>> short_patterns;
+    std::vector<range> short_ranges;
+    /*
+     * Optional caches shared by the queries (see set_split_cache and set_result_cache): the ranges
+     * of rev(p[1..i]) (key 'r' + p[1..i]) and p[i+1..m] (key 's' + p[i+1..m]) and the
+     * occurrences of complete patterns
+     * */
+    typedef std::pair<bool, std::pair<size_t,size_t> > batch_range;
+    mutable query_cache<batch_range> split_cache;
+    mutable query_cache<std::vector<index_long>> result_cache;
 
     public:
         explicit SelfGrammarIndexPTS(const int &);
@@ -43,11 +63,98 @@ class SelfGrammarIndexPTS:public SelfGrammarIndexPT{
         const m_patricia::compact_patricia_tree& get_pt_suffixes()const override{  return SelfGrammarIndexPT::get_pt_suffixes();}
 
 //        void locate2( std::string& , sdsl::bit_vector &)  ;
-        void locate2( std::string & , std::vector<uint> & );
-        void locate( std::string & , std::vector<uint> & ) override;
-        void locateNoTrie( std::string &, std::vector<uint> &) override;
+        void locate2( std::string & , std::vector<index_long> & );
+        using SelfGrammarIndex::locate;
+        using SelfGrammarIndex::locateNoTrie;
+        using SelfGrammarIndex::find_ranges;
+        void locate( std::string_view , std::vector<index_long> & ) const override;
+        bool locate( std::string_view , std::vector<index_long> & , const size_t & ) const override;
+        void locateNoTrie( std::string_view, std::vector<index_long> &) const override;
+        void locate_batch(const std::vector<std::string> &, std::vector<std::vector<index_long>> &) override;
+        size_t count(const std::string &) override;
+        /*
+         * Reentrant queries, const and with all the scratch state in the context of the
+         * calling thread, so one instance can be shared by concurrent queries
+         * */
+        void locate(std::string_view, std::vector<index_long> &, query_context &) const;
+        size_t count(std::string_view, query_context &) const;
+        /*
+         * Precompute the grid ranges of every pattern of 2 to q (at most 7, 0 removes them) symbols
+         * of the text, the queries of at most q symbols take them from the table
+         * */
+        void build_short_ranges(const size_t & q);
+        /*
+         * Grid ranges of the splits of the pattern (longer than one symbol) that find
+         * the rules and the suffixes, the ranges the locate queries expand
+         * */
+        void split_ranges(std::string &, std::vector<range> &) const;
+        bool split_range(std::string &, const size_t &, range &) const override;
+        /*
+         * Keep the ranges of at most capacity pattern pieces and the occurrences of the complete
+         * patterns in at most budget bytes (0 disables them)
+         * */
+        void set_split_cache(const size_t & capacity){ split_cache.reset(capacity); }
+        /*
+         * Also drop the short pattern table and empty the split/result caches, a miss in the
+         * table only means no occurrences for the grammar it was built from
+         * */
+        void clear_query_structures() override;
+        void set_result_cache(const size_t & budget){ result_cache.reset(budget); }
+        const query_cache<batch_range>& get_split_cache() const { return split_cache; }
+        const query_cache<std::vector<index_long>>& get_result_cache() const { return result_cache; }
+        using SelfGrammarIndex::display;
+        /*
+         * Locate reporting the occurrences to the sink report(pos) split by split,
+         * the search stops when report returns false (and returns false)
+         * */
+        template<typename F>
+        bool locate(std::string & pattern, const F & report) const{
+            query_context ctx;
+            return locate(pattern,report,ctx);
+        }
+        /*
+         * The grid ranges and the secondary occurrences use the buffers of ctx
+         * */
+        template<typename F>
+        bool locate(std::string & pattern, const F & report, query_context & ctx) const{
+
+            if(pattern.size() == 1)
+                return locate_ch(pattern[0],report);
+
+            const range *b, *e;
+            if(find_short(pattern,b,e))
+            {
+                for (; b != e; ++b) {
+                    long len = b->len;
+                    if(!find_second_occ(b->x1,b->x2,b->y1,b->y2,len,report,ctx))
+                        return false;
+                }
+                return true;
+            }
+
+            size_t p_n = pattern.size();
+
+            for (size_t i = 1; i <= p_n ; ++i) {
+
+                size_t p_r1, p_r2, p_c1, p_c2;
+
+                if(!rules_range(pattern, i, p_r1, p_r2, ctx))
+                    continue;
+
+                if(!sfx_range(pattern, i, p_c1, p_c2, ctx))
+                    continue;
+
+                auto x1 = (index_long) p_r1, x2 = (index_long) p_r2, y1 = (index_long) p_c1, y2 = (index_long) p_c2;
+
+                long len = i;
+
+                if(!find_second_occ(x1,x2,y1,y2,len,report,ctx))
+                    return false;
+            }
+            return true;
+        }
         compressed_grammar& get_grammar() override { return _g;}
-        void display(const std::size_t& , const std::size_t&, std::string & ) override ;
+        void display(const std::size_t& , const std::size_t&, std::string & ) const override ;
 
         void save(std::fstream& ) override;
 
@@ -62,7 +169,7 @@ class SelfGrammarIndexPTS:public SelfGrammarIndexPT{
 #endif
         ) override;
 
-        void test_findSecondOcc(long len,binary_relation::bin_long x1,binary_relation::bin_long x2,binary_relation::bin_long y1,binary_relation::bin_long y2,std::vector<uint> &occ){
+        void test_findSecondOcc(long len,binary_relation::bin_long x1,binary_relation::bin_long x2,binary_relation::bin_long y1,binary_relation::bin_long y2,std::vector<index_long> &occ){
 
             const auto& g_tree = _g.get_parser_tree();
             std::vector< std::pair<size_t,size_t> > pairs;
@@ -74,17 +181,17 @@ class SelfGrammarIndexPTS:public SelfGrammarIndexPT{
             for (auto &pair : pairs) {
                 size_t p = grid.first_label_col(pair.second);
                 size_t pos_p = _g.offsetText(g_tree[p]);
-                unsigned int parent = g_tree.parent(g_tree[p]);
+                size_t parent = g_tree.parent(g_tree[p]);
                 long   l = long (- len + pos_p) - _g.offsetText(parent);
                 find_second_occ(l,parent,occ);
             }
 
         }
 
-        void find_ranges_trie(std::string &, std::vector<uint>& ) override;
-        void find_ranges_trie(std::string &, std::vector<uint>& , std::vector<range> &) override;
-        void find_ranges(std::string &, std::vector<uint> &) override;
-        void find_ranges_dfs(std::string &, std::vector<uint>& ) override{}
+        void find_ranges_trie(std::string &, std::vector<index_long>& ) override;
+        void find_ranges_trie(std::string &, std::vector<index_long>& , std::vector<range> &) override;
+        void find_ranges(std::string_view, std::vector<index_long> &) const override;
+        void find_ranges_dfs(std::string &, std::vector<index_long>& ) override{}
 
         void load_rules_pt(fstream& f) override{ SelfGrammarIndexPT::load_rules_pt(f);}
         void load_sfx_pt(fstream& f) override{ SelfGrammarIndexPT::load_sfx_pt(f);}
@@ -98,6 +205,61 @@ class SelfGrammarIndexPTS:public SelfGrammarIndexPT{
 
         size_t _st(const size_t & i)const;
 
+        static uint64_t short_key(const char * p, const size_t & m);
+        /*
+         * If the pattern is short enough for the table of build_short_ranges, set [b,e) to its
+         * ranges (empty if it does not occur) and return true
+         * */
+        bool find_short(const std::string &, const range *& b, const range *& e) const;
+
+        /*
+         * Find the range [r1,r2] of rules whose expansion ends with p[1..i]
+         * return false if the range is empty. The key of the split cache is built in ctx.key
+         * */
+        bool rules_range(std::string &, const size_t & i, size_t & r1, size_t & r2, query_context & ctx) const;
+        /*
+         * Find the range [c1,c2] of grammar suffixes that start with p[i+1..m]
+         * return false if the range is empty
+         * */
+        bool sfx_range(std::string &, const size_t & i, size_t & c1, size_t & c2, query_context & ctx) const;
+        /*
+         * The searches of rules_range and sfx_range without the split cache
+         * */
+        bool search_rules_range(std::string &, const size_t & i, size_t & r1, size_t & r2) const;
+
+        bool search_sfx_range(std::string &, const size_t & i, size_t & c1, size_t & c2) const;
+        /*
+         * locate without the result cache
+         * */
+        void locate_splits(std::string &, std::vector<index_long> &, query_context &) const;
+        /*
+         * Append the cached occurrences of the pattern to occ, return false if they are not cached
+         * */
+        bool cached_result(const std::string &, std::vector<index_long> &) const;
+        /*
+         * Cache occ[first..] as the occurrences of the pattern
+         * */
+        void cache_result(const std::string &, const std::vector<index_long> &, const size_t & first) const;
+        /*
+         * Patricia tree step of rules_range/sfx_range: set the intervals of the binary searches
+         * of the lower (lo) and upper (up) bounds of the range
+         * */
+        void rules_range_bounds(std::string &, const size_t & i, bound_search & lo, bound_search & up) const;
+
+        void sfx_range_bounds(std::string &, const size_t & i, bound_search & lo, bound_search & up) const;
+        /*
+         * Comparisons of the binary searches: rev(p[1..i]) against the rule a and
+         * p[i+1..m] against the grammar suffix starting at sfx_preorder (with rule X)
+         * */
+        int rules_cmp(std::string &, const size_t & i, const grammar_representation::g_long & a) const;
+
+        int sfx_cmp(std::string &, const size_t & i, const size_t & sfx_preorder, const size_t & X) const;
+        /*
+         * rules_range (rules = true) or sfx_range of every (pattern, i) of Q with their
+         * binary searches interleaved by batch_bound, R[k] = (non empty, range) of Q[k]
+         * */
+        void batch_ranges(std::vector<std::pair<std::string*,size_t>> & Q, const bool & rules, std::vector<batch_range> & R, query_context & ctx) const;
+
 
 
 
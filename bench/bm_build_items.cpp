@@ -41,7 +41,8 @@ auto BM_BuildGIndexPT = [](benchmark::State &t_state,
                            const auto &t_data_path,
                            const auto &t_basics_fn,
                            const auto &t_repair_fn,
-                           const auto &t_suffixes_fn) {
+                           const auto &t_suffixes_fn,
+                           const auto &t_count_fn) {
   std::size_t n = 0;
   SelfGrammarIndexBS idx;
   grammar *not_compressed_grammar = nullptr;
@@ -63,6 +64,11 @@ auto BM_BuildGIndexPT = [](benchmark::State &t_state,
     std::fstream fbasics(t_basics_fn, std::ios::out | std::ios::binary);
     idx.save(fbasics);
   }
+  {
+    // Weights of count, they are not part of the basics stream
+    std::fstream fcount(t_count_fn, std::ios::out | std::ios::binary);
+    idx.save_count(fcount);
+  }
   {
     std::fstream frepair(t_repair_fn, std::ios::out | std::ios::binary);
     if (not_compressed_grammar != nullptr) {
@@ -150,9 +156,10 @@ int main(int argc, char **argv) {
   std::string repair_fn = "grepair_" + data_filename + ".gi";
   std::string suffixes_fn = "suffixes_" + data_filename + ".gi";
   std::string pts_idx_fn = "pts-idx_" + data_filename + ".gi";
+  std::string count_fn = "count_" + data_filename + ".gi";
 
   if (!file_exists(basics_fn)) {
-    benchmark::RegisterBenchmark("G-Index-PT", BM_BuildGIndexPT, data_path, basics_fn, repair_fn, suffixes_fn);
+    benchmark::RegisterBenchmark("G-Index-PT", BM_BuildGIndexPT, data_path, basics_fn, repair_fn, suffixes_fn, count_fn);
   }
 
   benchmark::RegisterBenchmark("G-Index-PT",
@@ -0,0 +1,450 @@
+//
+// Checks of the alternative query paths of the index against the reference ones.
+//
+
+#include <iostream>
+#include <fstream>
+#include <algorithm>
+#include <random>
+#include <sstream>
+#include <set>
+#include <thread>
+#include <atomic>
+#include <cstdio>
+#include <functional>
+
+#include <gflags/gflags.h>
+
+#include <SelfGrammarIndexPTS.h>
+
+#include "bm_locate.h"
+
+DEFINE_string(patterns, "", "Patterns file. (MANDATORY)");
+DEFINE_string(data_dir, "./", "Data directory.");
+DEFINE_string(data_name, "data", "Data file basename.");
+DEFINE_int32(s, 8, "Sampling parameter s of the index.");
+DEFINE_int32(rule_q, 4, "Symbols of the rule q-gram words of the comparison check.");
+DEFINE_int32(fingerprints, 4, "Minimum number of pattern symbols compared with the rule fingerprints in the check.");
+DEFINE_int32(short_rules, 8, "Maximum length of the rules stored explicitly in the check.");
+DEFINE_int32(rule_cache, 4096, "Number of rules kept by the rule cache in the check.");
+DEFINE_int32(rule_cache_len, 16, "Symbols kept per rule by the rule cache in the check.");
+DEFINE_int32(short_q, 3, "Maximum length (at most 7) of the patterns of the short range table in the check, their prefixes are also checked.");
+DEFINE_int32(split_cache, 4096, "Number of pattern pieces kept by the split cache in the check.");
+DEFINE_int64(result_cache, 1 << 22, "Bytes for the cached occurrences of complete patterns in the check.");
+DEFINE_int64(heavy_occ, 1 << 24, "Bytes for the text positions of the heavy rules in the check.");
+DEFINE_int32(threads, 4, "Number of threads sharing the index in the concurrent check (0 disables it).");
+DEFINE_int32(n_intervals, 1000, "Number of random text intervals extracted by the display checks.");
+DEFINE_int32(interval_len, 64, "Maximum length of the random text intervals.");
+DEFINE_int32(gap, 16, "Gap of the display_batch check (intervals closer than it are merged).");
+DEFINE_int32(display_samples, 0, "Block size of the display samples used by the display checks (0 disables them).");
+
+std::size_t n_errors = 0;
+
+// Compare the occurrences found by a path with the reference ones (sorted)
+void Check(const std::string &t_path,
+           const std::string &t_pattern,
+           std::vector<index_long> t_occ,
+           const std::vector<index_long> &t_expected) {
+  std::sort(t_occ.begin(), t_occ.end());
+  if (t_occ != t_expected) {
+    ++n_errors;
+    std::cerr << t_path << ": " << t_occ.size() << " occurrences instead of " << t_expected.size()
+              << " for pattern '" << t_pattern << "'" << std::endl;
+  }
+}
+
+// Compare an extracted interval with the text
+void CheckText(const std::string &t_path,
+               const std::pair<std::size_t, std::size_t> &t_interval,
+               const std::string &t_str,
+               const std::string &t_text) {
+  if (t_str != t_text.substr(t_interval.first, t_interval.second - t_interval.first + 1)) {
+    ++n_errors;
+    std::cerr << t_path << ": wrong text for the interval [" << t_interval.first << ", " << t_interval.second << "]"
+              << std::endl;
+  }
+}
+
+std::string LoadText(const std::string &t_file) {
+  std::ifstream f(t_file, std::ios::in | std::ios::binary);
+  std::string text((std::istreambuf_iterator<char>(f)), std::istreambuf_iterator<char>());
+  if (!text.empty() && text.back() == '\0') {
+    text.pop_back();
+  }
+  return text;
+}
+
+std::shared_ptr<SelfGrammarIndexPTS> LoadIndex(const std::string &t_file, std::size_t t_s) {
+  auto idx = std::make_shared<SelfGrammarIndexPTS>(t_s);
+  std::fstream fpts(t_file, std::ios::in | std::ios::binary);
+  idx->load(fpts);
+  return idx;
+}
+
+int main(int argc, char **argv) {
+  gflags::AllowCommandLineReparsing();
+  gflags::ParseCommandLineFlags(&argc, &argv, false);
+
+  if (FLAGS_patterns.empty() || FLAGS_data_name.empty() || FLAGS_data_dir.empty()) {
+    std::cerr << "Command-line error!!!" << std::endl;
+    return 1;
+  }
+
+  auto patterns = ReadPatterns(FLAGS_patterns);
+  std::string file = FLAGS_data_dir + "/" + std::to_string(FLAGS_s) + "_pts-idx_" + FLAGS_data_name + ".gi";
+
+  // Reference index: no optional structure, the occurrences of every split are expanded by find_second_occ_plain
+  auto ref = LoadIndex(file, FLAGS_s);
+  auto idx = LoadIndex(file, FLAGS_s);
+
+  // Random intervals of the display checks
+  auto text = LoadText(FLAGS_data_dir + "/" + FLAGS_data_name);
+  std::vector<std::pair<std::size_t, std::size_t>> intervals;
+  if (!text.empty()) {
+    std::mt19937_64 rng(42);
+    std::uniform_int_distribution<std::size_t> start(0, text.size() - 1);
+    std::uniform_int_distribution<std::size_t> len(1, std::max(FLAGS_interval_len, 1));
+    for (int k = 0; k < FLAGS_n_intervals; ++k) {
+      auto i = start(rng);
+      intervals.emplace_back(i, std::min(i + len(rng), text.size()) - 1);
+    }
+  }
+
+  // The prefixes of 2 to short_q symbols of the patterns are also checked, they are the queries of the short range table
+  std::set<std::string> prefixes;
+  for (const auto &p : patterns) {
+    for (std::size_t m = 2; m <= std::min<std::size_t>(FLAGS_short_q, 7) && m < p.size(); ++m) {
+      prefixes.insert(p.substr(0, m));
+    }
+  }
+  std::vector<std::string> queries(patterns.begin(), patterns.end());
+  queries.insert(queries.end(), prefixes.begin(), prefixes.end());
+
+  std::vector<std::string> checked;
+  std::vector<std::vector<index_long>> checked_occs;
+  for (const auto &p : queries) {
+    std::string pattern = p;
+    if (pattern.size() < 2) {
+      continue;
+    }
+
+    std::vector<range> ranges;
+    ref->split_ranges(pattern, ranges);
+
+    std::vector<index_long> expected;
+    for (const auto &r : ranges) {
+      ref->find_second_occ_plain(r.x1, r.x2, r.y1, r.y2, r.len, expected);
+    }
+    std::sort(expected.begin(), expected.end());
+    checked.push_back(p);
+    checked_occs.push_back(expected);
+
+    {
+      std::vector<index_long> occ;
+      for (const auto &r : ranges) {
+        idx->find_second_occ_par(r.x1, r.x2, r.y1, r.y2, r.len, occ);
+      }
+      Check("find_second_occ_par", pattern, occ, expected);
+    }
+
+    {
+      std::vector<index_long> occ;
+      for (const auto &r : ranges) {
+        idx->find_second_occ_dag(r.x1, r.x2, r.y1, r.y2, r.len, occ);
+      }
+      Check("find_second_occ_dag", pattern, occ, expected);
+    }
+
+    {
+      // Grouped expansion with prefetching of the stages of the next occurrences
+      std::vector<index_long> occ;
+      for (const auto &r : ranges) {
+        idx->find_second_occ(r.x1, r.x2, r.y1, r.y2, r.len, occ);
+      }
+      Check("find_second_occ (grouped)", pattern, occ, expected);
+    }
+  }
+
+  // Complete queries of the index (with the optional structures of every check) against the reference occurrences
+  auto CheckLocate = [&](const std::string &t_config) {
+    query_context ctx;
+    for (std::size_t k = 0; k < checked.size(); ++k) {
+      std::vector<index_long> occ;
+      std::string pattern = checked[k];
+      idx->locate(pattern, occ);
+      Check("locate" + t_config, checked[k], occ, checked_occs[k]);
+
+      occ.clear();
+      pattern = checked[k];
+      idx->locateNoTrie(pattern, occ);
+      Check("locateNoTrie" + t_config, checked[k], occ, checked_occs[k]);
+
+      occ.clear();
+      idx->locate(std::string_view(checked[k]), occ, ctx);
+      Check("locate (const)" + t_config, checked[k], occ, checked_occs[k]);
+    }
+
+    // Interleaved binary searches of all the patterns
+    std::vector<std::vector<index_long>> batch_occs;
+    idx->locate_batch(checked, batch_occs);
+    for (std::size_t k = 0; k < checked.size(); ++k) {
+      Check("locate_batch" + t_config, checked[k], batch_occs[k], checked_occs[k]);
+    }
+  };
+
+  CheckLocate("");
+
+  // Early termination of the limited locate of the index and of the base class (split_range + sink)
+  for (std::size_t k = 0; k < checked.size(); ++k) {
+    const auto &expected = checked_occs[k];
+    std::size_t limit = expected.size() / 2;
+    for (int base = 0; base < 2; ++base) {
+      std::vector<index_long> occ;
+      std::string pattern = checked[k];
+      bool truncated = base ? idx->SelfGrammarIndex::locate(std::string_view(pattern), occ, limit) : idx->locate(pattern, occ, limit);
+      std::sort(occ.begin(), occ.end());
+      if (truncated != (limit < expected.size()) || occ.size() != limit
+          || !std::includes(expected.begin(), expected.end(), occ.begin(), occ.end())) {
+        ++n_errors;
+        std::cerr << (base ? "SelfGrammarIndex::locate" : "locate") << "(limit = " << limit << "): wrong occurrences for pattern '"
+                  << checked[k] << "'" << std::endl;
+      }
+    }
+  }
+
+  // Locate with each optional structure or query mode of the index enabled alone. The configurations
+  // with two runs also check the state the first run leaves (the warm caches)
+  struct LocateConfig {
+    std::string name;
+    std::function<void()> enable;
+    std::function<void()> disable;
+    int runs;
+  };
+  std::string fp_file = FLAGS_data_dir + "/fp_check_" + FLAGS_data_name + ".gi";
+  const std::vector<LocateConfig> configs = {
+      // Parallel expansion inside the splits instead of among them
+      {"par_second_occ", [&] { idx->set_par_second_occ(true); }, [&] { idx->set_par_second_occ(false); }, 1},
+      // Splits of every pattern distributed among the threads
+      {"par_locate", [&] { idx->set_par_locate(true, 2); }, [&] { idx->set_par_locate(false); }, 1},
+      // Comparisons of the binary searches decided by the q-gram words of the rules
+      {"rule_q", [&] { idx->build_rule_qgrams(FLAGS_rule_q); }, [&] { idx->build_rule_qgrams(0); }, 1},
+      // Long comparisons decided by the fingerprints of the rules
+      {"fingerprints", [&] { idx->build_fingerprints(FLAGS_fingerprints); }, [&] { idx->build_fingerprints(0); }, 1},
+      // Fingerprints of another seed saved and loaded over the ones of the default seed (the base is loaded with them)
+      {"loaded fingerprints",
+       [&] {
+         idx->build_fingerprints(FLAGS_fingerprints, 7);
+         {
+           std::fstream fout(fp_file, std::ios::out | std::ios::binary);
+           idx->save_fingerprints(fout);
+         }
+         idx->build_fingerprints(FLAGS_fingerprints);
+         std::fstream fin(fp_file, std::ios::in | std::ios::binary);
+         idx->load_fingerprints(fin);
+       },
+       [&] {
+         idx->build_fingerprints(0);
+         std::remove(fp_file.c_str());
+       },
+       1},
+      // Comparisons and expansions of the rules stored explicitly
+      {"short_rules", [&] { idx->build_short_rules(FLAGS_short_rules); }, [&] { idx->build_short_rules(0); }, 1},
+      // Comparisons with the cached rules, the second run finds the rules of the first one in the cache
+      {"rule_cache", [&] { idx->set_rule_cache(FLAGS_rule_cache, FLAGS_rule_cache_len); }, [&] { idx->set_rule_cache(0, 0); }, 2},
+      // Patterns of at most short_q symbols answered with the precomputed grid ranges
+      {"short_ranges", [&] { idx->build_short_ranges(FLAGS_short_q); }, [&] { idx->build_short_ranges(0); }, 1},
+      // Ranges of the pattern pieces and occurrences of the patterns taken from the caches on the second run
+      {"split/result caches",
+       [&] {
+         idx->set_split_cache(FLAGS_split_cache);
+         idx->set_result_cache(FLAGS_result_cache);
+       },
+       [&] {
+         idx->set_split_cache(0);
+         idx->set_result_cache(0);
+       },
+       2},
+      // Expansions that report the materialized positions of the heavy rules
+      {"heavy_occ", [&] { idx->build_heavy_occ(FLAGS_heavy_occ); }, [&] { idx->build_heavy_occ(0); }, 1},
+  };
+  for (const auto &config : configs) {
+    config.enable();
+    for (int run = 0; run < config.runs; ++run) {
+      CheckLocate(" with " + config.name + (run > 0 ? " (warm)" : ""));
+    }
+    config.disable();
+  }
+
+  // Display with the rules stored explicitly
+  idx->build_short_rules(FLAGS_short_rules);
+  {
+    query_context ctx;
+    std::string str;
+    for (const auto &r : intervals) {
+      idx->display(r.first, r.second, str, ctx);
+      CheckText("display with short_rules", r, str, text);
+      idx->display_L(r.first, r.second, str, ctx);
+      CheckText("display_L with short_rules", r, str, text);
+    }
+  }
+  idx->build_short_rules(0);
+
+  // Secondary occurrences that report the materialized positions of the heavy rules
+  idx->build_heavy_occ(FLAGS_heavy_occ);
+  for (std::size_t k = 0; k < checked.size(); ++k) {
+    std::string pattern = checked[k];
+    std::vector<range> ranges;
+    idx->split_ranges(pattern, ranges);
+
+    std::vector<index_long> occ;
+    for (const auto &r : ranges) {
+      idx->find_second_occ(r.x1, r.x2, r.y1, r.y2, r.len, occ);
+    }
+    Check("find_second_occ (grouped) with heavy_occ", checked[k], occ, checked_occs[k]);
+
+    occ.clear();
+    for (const auto &r : ranges) {
+      idx->find_second_occ_par(r.x1, r.x2, r.y1, r.y2, r.len, occ);
+    }
+    Check("find_second_occ_par with heavy_occ", checked[k], occ, checked_occs[k]);
+  }
+  idx->build_heavy_occ(0);
+
+  // count with the weights of the grid, loaded and then used in place from the read-only map of their file
+  {
+    idx->build_count();
+    std::string count_file = FLAGS_data_dir + "/count_check_" + FLAGS_data_name + ".gi";
+    {
+      std::fstream fout(count_file, std::ios::out | std::ios::binary);
+      idx->save_count(fout);
+    }
+    for (int mapped = 0; mapped < 2; ++mapped) {
+      if (mapped && !idx->map_count(count_file)) {
+        ++n_errors;
+        std::cerr << "map_count: " << count_file << " can not be mapped" << std::endl;
+        break;
+      }
+      for (std::size_t k = 0; k < checked.size(); ++k) {
+        if (idx->count(checked[k]) != checked_occs[k].size()) {
+          ++n_errors;
+          std::cerr << (mapped ? "count (mapped weights)" : "count") << ": wrong number of occurrences for pattern '"
+                    << checked[k] << "'" << std::endl;
+        }
+      }
+    }
+    std::remove(count_file.c_str());
+  }
+
+  // Display paths against the text
+  if (FLAGS_display_samples > 0) {
+    // The samples are stored in their own file, built and saved on the first run
+    std::string samples_file = FLAGS_data_dir + "/samples_" + std::to_string(FLAGS_display_samples) + "_"
+        + FLAGS_data_name + ".gi";
+    std::fstream fin(samples_file, std::ios::in | std::ios::binary);
+    if (fin.is_open()) {
+      idx->load_display_samples(fin);
+    } else {
+      idx->build_display_samples(FLAGS_display_samples);
+      std::fstream fout(samples_file, std::ios::out | std::ios::binary);
+      idx->save_display_samples(fout);
+    }
+  }
+
+  {
+    // Reference (no samples) and the index (with the samples when they are enabled)
+    query_context ctx;
+    std::string str;
+    for (const auto &r : intervals) {
+      ref->display(r.first, r.second, str, ctx);
+      CheckText("display (reference)", r, str, text);
+      idx->display(r.first, r.second, str, ctx);
+      CheckText("display", r, str, text);
+      idx->display_L(r.first, r.second, str, ctx);
+      CheckText("display_L (expand_interval_lz)", r, str, text);
+    }
+  }
+
+  {
+    query_context ctx;
+    std::vector<std::string> out;
+    idx->display_batch(intervals, out, ctx, FLAGS_gap);
+    for (std::size_t k = 0; k < intervals.size(); ++k) {
+      CheckText("display_batch", intervals[k], out[k], text);
+    }
+    // No merged intervals, every one only shares the top of the descent with the previous
+    idx->display_batch(intervals, out, ctx, 0);
+    for (std::size_t k = 0; k < intervals.size(); ++k) {
+      CheckText("display_batch(gap = 0)", intervals[k], out[k], text);
+    }
+  }
+
+  {
+    // Sequential reader and chunked extract, the odd chunk sizes end in the middle of the leaves
+    for (const auto &r : intervals) {
+      auto reader = idx->open_reader(r.first, r.second);
+      std::string str;
+      char buf[7];
+      std::size_t m;
+      while (!reader.eof() && (m = reader.read(buf, sizeof(buf))) > 0) {
+        str.append(buf, m);
+      }
+      CheckText("open_reader", r, str, text);
+
+      std::ostringstream out;
+      idx->extract(r.first, r.second, out, 5);
+      CheckText("extract", r, out.str(), text);
+    }
+  }
+
+  // Concurrent const queries sharing the index (and its caches), every thread with its own context and
+  // starting at a different pattern/interval, compared with the single-threaded results
+  if (FLAGS_threads > 0) {
+    idx->set_rule_cache(FLAGS_rule_cache, FLAGS_rule_cache_len);
+    idx->set_split_cache(FLAGS_split_cache);
+    idx->set_result_cache(FLAGS_result_cache);
+
+    std::atomic<std::size_t> n_thread_errors{0};
+    std::vector<std::thread> threads;
+    for (int t = 0; t < FLAGS_threads; ++t) {
+      threads.emplace_back([&, t]() {
+        query_context ctx;
+        std::vector<index_long> occ;
+        for (std::size_t k = 0; k < checked.size(); ++k) {
+          auto q = (k + t * checked.size() / FLAGS_threads) % checked.size();
+          occ.clear();
+          idx->locate(std::string_view(checked[q]), occ, ctx);
+          std::sort(occ.begin(), occ.end());
+          if (occ != checked_occs[q]) {
+            ++n_thread_errors;
+          }
+        }
+        std::string str;
+        for (std::size_t k = 0; k < intervals.size(); ++k) {
+          const auto &r = intervals[(k + t * intervals.size() / FLAGS_threads) % intervals.size()];
+          idx->display(r.first, r.second, str, ctx);
+          if (str != text.substr(r.first, r.second - r.first + 1)) {
+            ++n_thread_errors;
+          }
+        }
+      });
+    }
+    for (auto &th : threads) {
+      th.join();
+    }
+
+    if (n_thread_errors > 0) {
+      std::cerr << "concurrent locate/display (" << FLAGS_threads << " threads): " << n_thread_errors
+                << " wrong results" << std::endl;
+      n_errors += n_thread_errors;
+    }
+
+    idx->set_rule_cache(0, 0);
+    idx->set_split_cache(0);
+    idx->set_result_cache(0);
+  }
+
+  std::cout << checked.size() << " patterns and " << intervals.size() << " intervals checked, " << n_errors << " mismatches"
+            << std::endl;
+
+  return n_errors == 0 ? 0 : 1;
+}
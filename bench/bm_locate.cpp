@@ -27,10 +27,27 @@ DEFINE_double(min_time, 0, "Minimum time (seconds) for the locate query micro be
 
 DEFINE_bool(print_result, false, "Execute benchmark that print results per index.");
 
+DEFINE_int32(rule_cache, 0, "Number of rules kept in the comparison cache (0 disables it).");
+DEFINE_int32(rule_cache_len, 32, "Number of symbols kept per rule in the comparison cache.");
+DEFINE_int32(rule_q, 0, "Number of symbols of every rule packed in words for the comparisons (0 disables it).");
+DEFINE_int64(heavy_budget, 0, "Bytes for the materialized positions of the rules with more occurrences (0 disables them).");
+DEFINE_int32(fingerprints, 0, "Minimum number of pattern symbols compared with the rule fingerprints (0 disables them).");
+DEFINE_uint64(fingerprint_seed, karp_rabin::default_seed, "Seed of the base of the rule fingerprints.");
+DEFINE_int32(short_rules, 0, "Maximum length of the rules whose expansions are stored explicitly (0 disables them).");
+DEFINE_int32(short_q, 0, "Maximum length of the patterns whose ranges are precomputed (0 disables them).");
+DEFINE_int32(split_cache, 0, "Number of pattern pieces whose rule/suffix ranges are cached (0 disables it).");
+DEFINE_int64(result_cache, 0, "Bytes for the cached occurrences of complete patterns (0 disables it).");
+DEFINE_string(locate, "no_trie", "Locate query measured: no_trie (locateNoTrie) or locate.");
+DEFINE_bool(par_second_occ, false, "Expand the secondary occurrences of every split with all the threads (locate only).");
+DEFINE_bool(par_locate, false, "Run the splits of the long patterns in parallel (locate only).");
+DEFINE_int32(par_locate_min, 16, "Minimum length of the patterns whose splits run in parallel.");
+DEFINE_bool(mmap_count, false, "Use the weights of count in place from a read-only memory map of their file.");
+
 class Factory {
  public:
   Factory(std::string t_idx_dir, const std::string &t_data_name) : idx_dir_{std::move(t_idx_dir)} {
     idx_suffix_ = "pts-idx_" + t_data_name + ".gi";
+    count_suffix_ = "count_" + t_data_name + ".gi";
   }
 
   struct Index {
@@ -45,9 +62,31 @@ class Factory {
     }
 
     Index index;
-    std::fstream fpts(idx_dir_ + "/" + std::to_string(t_s) + "_" + idx_suffix_, std::ios::in | std::ios::binary);
+    std::string file = idx_dir_ + "/" + std::to_string(t_s) + "_" + idx_suffix_;
     index.idx = std::make_shared<SelfGrammarIndexPTS>(t_s);
-    index.idx->load(fpts);
+    {
+      std::fstream fpts(file, std::ios::in | std::ios::binary);
+      index.idx->load(fpts);
+    }
+    if (FLAGS_mmap_count) {
+      index.idx->map_count(idx_dir_ + "/" + count_suffix_);
+    } else {
+      // Weights of count (see bm_build_items), count enumerates the occurrences without them
+      std::fstream fcount(idx_dir_ + "/" + count_suffix_, std::ios::in | std::ios::binary);
+      if (fcount.is_open()) {
+        index.idx->load_count(fcount);
+      }
+    }
+    index.idx->set_rule_cache(FLAGS_rule_cache, FLAGS_rule_cache_len);
+    index.idx->build_rule_qgrams(FLAGS_rule_q);
+    index.idx->build_heavy_occ(FLAGS_heavy_budget);
+    index.idx->build_fingerprints(FLAGS_fingerprints, FLAGS_fingerprint_seed);
+    index.idx->build_short_rules(FLAGS_short_rules);
+    index.idx->build_short_ranges(FLAGS_short_q);
+    index.idx->set_split_cache(FLAGS_split_cache);
+    index.idx->set_result_cache(FLAGS_result_cache);
+    index.idx->set_par_second_occ(FLAGS_par_second_occ);
+    index.idx->set_par_locate(FLAGS_par_locate, FLAGS_par_locate_min);
     index.size = index.idx->size_in_bytes() - index.idx->get_grammar().get_right_trie().size_in_bytes()
         - index.idx->get_grammar().get_left_trie().size_in_bytes();
 
@@ -59,6 +98,7 @@ class Factory {
  private:
   std::string idx_dir_;
   std::string idx_suffix_;
+  std::string count_suffix_;
 
   std::map<std::size_t, Index> indexes_;
 };
@@ -86,8 +126,12 @@ int main(int argc, char **argv) {
     auto idx = factory->make(tt_state.range(0));
 
     auto locate = [idx](auto ttt_pattern) {
-      std::vector<uint> occs;
-      idx.idx->locateNoTrie(ttt_pattern, occs);
+      std::vector<index_long> occs;
+      if (FLAGS_locate == "locate") {
+        idx.idx->locate(ttt_pattern, occs);
+      } else {
+        idx.idx->locateNoTrie(ttt_pattern, occs);
+      }
 
       return occs;
     };
@@ -339,6 +339,13 @@ auto g_imp_build_basics = [](benchmark::State &st, const string &file_collection
 
     g_index.save(f_gidx);
     g_index.save(fbasics);
+    {
+        /*
+         * The weights of count are a component of their own, the indexes built from the basics share it
+         * */
+        fstream f_sw(file_out+"_grid_sw", std::ios::out | std::ios::binary);
+        g_index.save_count(f_sw);
+    }
     not_compressed_grammar.save(frepair);
     unsigned long num_sfx = grammar_sfx.size();
     sdsl::serialize(num_sfx,fsuffixes);
@@ -198,7 +198,7 @@ auto gibslocate = [](benchmark::State &st, const string &file_index, const uint&
             std::string query;
             query.resize(len);
             std::copy(patterns[ii].begin(),patterns[ii].begin()+len,query.begin());
-            std::vector<uint> X;
+            std::vector<index_long> X;
             if(trie)
                 idx_gibs.locate(query,X);
             else
@@ -263,7 +263,7 @@ auto giptslocate = [](benchmark::State &st, const string &file_index, const uint
             std::string query;
             query.resize(len);
             std::copy(patterns[ii].begin(),patterns[ii].begin()+len,query.begin());
-            std::vector<uint> X;
+            std::vector<index_long> X;
 
             if(trie)
                 idx_gipts.locate(query,X);
@@ -343,7 +343,7 @@ auto giqgramlocate = [](benchmark::State &st, const string &file_index, const ui
             std::string query;
             query.resize(len);
             std::copy(patterns[ii].begin(),patterns[ii].begin()+len,query.begin());
-            std::vector<uint> X;
+            std::vector<index_long> X;
 
 //            std::cout <<query<<"-"<< queries << std::endl;
             if(op == 2){
@@ -58,49 +58,48 @@ void load_data(const size_t &_max,std::string& data, const std::string &coll) {
 }
 
 
-void load_X_p(SelfGrammarIndex* idx, const int& code, int op)
+/*
+ * Files of the alternative representations of X_p and Z
+ * */
+std::string X_p_file(const int& code, int op)
 {
-    fstream f;
     switch (op){
-        case 1:{
-            f.open(read_path+std::to_string(code)+"_X_p_gmr",std::ios::in|std::ios::binary);
-            ///std::cout<<"opening "+read_path+std::to_string(code)+"_X_p_gmr"<<std::endl;
-            break;
-        }
-        case 2:{
-            f.open(read_path+std::to_string(code)+"_X_p_gmr_rs",std::ios::in|std::ios::binary);
-            ///std::cout<<"opening "+read_path+std::to_string(code)+"_X_p_gmr_rs"<<std::endl;
-            break;
-        }
-        case 3:{
-            f.open(read_path+std::to_string(code)+"_X_p_ap",std::ios::in|std::ios::binary);
-            ///std::cout<<"opening "+read_path+std::to_string(code)+"_X_p_ap"<<std::endl;
-            break;
-        }
-        default:{
-            f.open(read_path+std::to_string(code)+"_X_p_gmr_rs",std::ios::in|std::ios::binary);
-            ///std::cout<<"opening "+read_path+std::to_string(code)+"_X_p_gmr_rs"<<std::endl;
-            break;
-        }
+        case 1: return read_path+std::to_string(code)+"_X_p_gmr";
+        case 2: return read_path+std::to_string(code)+"_X_p_gmr_rs";
+        case 3: return read_path+std::to_string(code)+"_X_p_ap";
+        default: return read_path+std::to_string(code)+"_X_p_gmr_rs";
     }
-    idx->get_grammar().load_X_p(f);
 }
-void load_z(SelfGrammarIndex* idx, const int& code, int op)
+std::string z_file(const int& code, int op)
 {
-    fstream f;
     switch (op){
-        case 1:{
-            f.open(read_path+std::to_string(code)+"_z_sd",std::ios::in|std::ios::binary);
-        }break;
-        case 2:{
-            f.open(read_path+std::to_string(code)+"_z_rrr",std::ios::in|std::ios::binary);
-        }break;
-        default:{
-            f.open(read_path+std::to_string(code)+"_z_sd",std::ios::in|std::ios::binary);
-        }break;
+        case 1: return read_path+std::to_string(code)+"_z_sd";
+        case 2: return read_path+std::to_string(code)+"_z_rrr";
+        default: return read_path+std::to_string(code)+"_z_sd";
     }
+}
+
+void load_X_p(SelfGrammarIndex* idx, const int& code, int op)
+{
+    fstream f(X_p_file(code,op),std::ios::in|std::ios::binary);
+    idx->get_grammar().load_X_p(f);
+}
+void load_z(SelfGrammarIndex* idx, const int& code, int op)
+{
+    fstream f(z_file(code,op),std::ios::in|std::ios::binary);
     idx->get_grammar().load_z(f);
 }
+/*
+ * Weights of the grid used by count, they are an optional component of the index
+ * (indexes built before them do not have the file and count enumerates the occurrences)
+ * */
+void load_count(SelfGrammarIndex* idx, const int& code)
+{
+    fstream f(read_path+std::to_string(code)+"_grid_sw",std::ios::in|std::ios::binary);
+    if(f.is_open())
+        idx->load_count(f);
+}
+
 SelfGrammarIndex* load_idx (const int& op_i,const int& sampling, const int& code ){
 
     SelfGrammarIndex* idx;
@@ -135,42 +134,28 @@ SelfGrammarIndex* load_idx (const int& op_i,const int& sampling, const int& code
             break;
         }
     }
+    load_count(idx,code);
     return idx;
 }
 
-SelfGrammarIndex* load_idx (const int& op_i,const int& sampling,const int& op_x_p,const int& op_z, const int& op_trie, const int& code )
+/*
+ * Index stored one component per file. With parallel every component is read by its own task,
+ * with lazy_tries the left/right tries are read on their first access instead (e.g. never when
+ * only locateNoTrie is used), see SelfGrammarIndex::load_components
+ * */
+SelfGrammarIndex* load_idx (const int& op_i,const int& sampling,const int& op_x_p,const int& op_z, const int& op_trie, const int& code,
+                            const bool& parallel = false, const bool& lazy_tries = false)
 {
 
     SelfGrammarIndex* idx;
     //LOADING INDICE TYPE
     switch (op_i){ // indice type
-        case 1:{ //binary-search
-            idx = new SelfGrammarIndexBS();
-            break;
-        }
         case 2:{ //full-pt
             idx = new SelfGrammarIndexPT();
-            {
-                fstream f(read_path+std::to_string(code)+"_g_rules_pt",std::ios::in|std::ios::binary);
-                idx->load_rules_pt(f);
-            }
-            {
-                fstream f (read_path+std::to_string(code)+"_g_sfx_pt",std::ios::in|std::ios::binary);
-                idx->load_sfx_pt(f);
-            }
             break;
         }
         case 3:{ //sampled-pt
             idx = new SelfGrammarIndexPTS(sampling);
-            {
-                fstream f(read_path+std::to_string(code)+"_g_rules_pts_"+std::to_string(sampling),std::ios::in|std::ios::binary);
-                idx->load_rules_pt(f);
-            }
-
-            {
-                fstream f (read_path+std::to_string(code)+"_g_sfx_pts_"+std::to_string(sampling),std::ios::in|std::ios::binary);
-                idx->load_sfx_pt(f);
-            }
             break;
         }
 //        case 4:{ //binary-search
@@ -183,97 +168,33 @@ SelfGrammarIndex* load_idx (const int& op_i,const int& sampling,const int& op_x_
         }
     }
 
-    //std::cout<<"index loaded.....\n";
-
-    load_X_p(idx,code,op_x_p);
-    //std::cout<<"X_p loaded.....\n";
-    load_z(idx,code,op_z);
-    //std::cout<<"z loaded.....\n";
-
-    ////////Loading F
-    {
-
-        fstream f (read_path+std::to_string(code)+"_F",std::ios::in|std::ios::binary);
-        idx->get_grammar().load_F(f);
-        //std::cout<<"F loaded.....\n";
-    }
-
-    ////////Loading Parser Tree
-    {
-
-        fstream f (read_path+std::to_string(code)+"_tree_dfuds",std::ios::in|std::ios::binary);
-        idx->get_grammar().load_mtree(f);
-        //std::cout<<"parser tree loaded.....\n";
-    }
-
-    ////////Loading L
-    {
-       fstream f (read_path+std::to_string(code)+"_L_sd",std::ios::in|std::ios::binary);
-       idx->get_grammar().load_l(f);
-        //std::cout<<"L loaded.....\n";
-//        fstream f (read_path+std::to_string(code)+"_l_rrr",std::ios::in|std::ios::binary);
-//        idx->get_grammar().load_l(f);
+    std::string prefix = read_path+std::to_string(code);
+    SelfGrammarIndex::component_files files;
+    if(op_i == 2){
+        files.rules_pt = prefix+"_g_rules_pt";
+        files.sfx_pt = prefix+"_g_sfx_pt";
     }
-
-    ////////Loading Y
-    {
-        fstream f (read_path+std::to_string(code)+"_y_sd",std::ios::in|std::ios::binary);
-        idx->get_grammar().load_y(f);
-        //std::cout<<"Y loaded.....\n";
-//        fstream f (read_path+std::to_string(code)+"_y_rrr",std::ios::in|std::ios::binary);
-//        idx->get_grammar().load_y(f);
-
+    if(op_i == 3){
+        files.rules_pt = prefix+"_g_rules_pts_"+std::to_string(sampling);
+        files.sfx_pt = prefix+"_g_sfx_pts_"+std::to_string(sampling);
     }
-
-
-    ////////Loading left/right trie
+    files.X_p = X_p_file(code,op_x_p);
+    files.z = z_file(code,op_z);
+    files.F = prefix+"_F";
+    files.tree = prefix+"_tree_dfuds";
+    files.L = prefix+"_L_sd";
+    files.y = prefix+"_y_sd";
+    files.alp = prefix+"_alp";
     if(op_trie == 1 || op_trie == 3){
-
-        {
-            fstream f (read_path+std::to_string(code)+"_left_trie",std::ios::in|std::ios::binary);
-            idx->get_grammar().load_ltrie(f);
-
-            //std::cout<<"_left_trie loaded.....\n";
-        }
-
-        {
-            fstream f (read_path+std::to_string(code)+"_right_trie",std::ios::in|std::ios::binary);
-            idx->get_grammar().load_rtrie(f);
-            //std::cout<<"_right_trie loaded.....\n";
-        }
-
-    }
-
-    //////////loading alp
-    {
-        fstream f (read_path+std::to_string(code)+"_alp",std::ios::in|std::ios::binary);
-        idx->get_grammar().load_alp(f);
-        //std::cout<<"_alp loaded.....\n";
-
-    }
-
-    //////////loading grid
-    {
-//        fstream f (read_path+std::to_string(code)+"_grid",std::ios::in|std::ios::binary);
-//        idx->get_grid().load(f);
-        //std::cout<<"_grid loaded.....\n";
-        fstream f (read_path+std::to_string(code)+"_int_vec_sl",std::ios::in|std::ios::binary);
-        idx->get_grid().load_SL(f);
-    }
-    {
-        fstream f (read_path+std::to_string(code)+"_wt_int_sb",std::ios::in|std::ios::binary);
-        idx->get_grid().load_SB(f);
-    }
-    {
-        fstream f (read_path+std::to_string(code)+"_grid_xb_rrr",std::ios::in|std::ios::binary);
-        idx->get_grid().load_XB(f);
-    }
-    {
-        fstream f (read_path+std::to_string(code)+"_grid_xa_rrr",std::ios::in|std::ios::binary);
-        idx->get_grid().load_XA(f);
+        files.left_trie = prefix+"_left_trie";
+        files.right_trie = prefix+"_right_trie";
     }
+    files.SL = prefix+"_int_vec_sl";
+    files.SB = prefix+"_wt_int_sb";
+    files.XB = prefix+"_grid_xb_rrr";
+    files.XA = prefix+"_grid_xa_rrr";
+    files.count = prefix+"_grid_sw";
 
-
+    idx->load_components(files,parallel,lazy_tries);
     return idx;
-};
-
+}
@@ -7,6 +7,8 @@
 binary_relation::binary_relation(const binary_relation &R) {
     SL = R.SL;
     SB = R.SB;
+    SW = R.SW;
+    SW_map = R.SW_map;
     XA = R.XA;
     XB = R.XB;
     xb_rank1 = bin_bit_vector_xb::rank_1_type(&XB);
@@ -64,7 +66,7 @@ void binary_relation::build( std::vector<point>::iterator begin,std::vector<poin
              * then add 1
              * */
             size_t p = 1;
-            for (uint j = 0; j < n_rows; ++j) {
+            for (size_t j = 0; j < n_rows; ++j) {
                 xb[p + card_rows[j]] = true;
                 p += card_rows[j] + 1;
             }
@@ -139,7 +141,7 @@ void binary_relation::build( std::vector<point>::iterator begin,std::vector<poin
 }
 
 
-void binary_relation::range2(binary_relation::bin_long & a1, binary_relation::bin_long & a2, binary_relation::bin_long & b1, binary_relation::bin_long & b2, std::vector<std::pair<size_t, size_t>> &Rel) {
+void binary_relation::range2(const bin_long & a1, const bin_long & a2, const bin_long & b1, const bin_long & b2, std::vector<std::pair<size_t, size_t>> &Rel) const {
 
     size_t p1,p2;
     p1 = map(a1);
@@ -153,7 +155,21 @@ void binary_relation::range2(binary_relation::bin_long & a1, binary_relation::bi
 }
 
 
-void binary_relation::range(binary_relation::bin_long & a1, binary_relation::bin_long & a2, binary_relation::bin_long & b1, binary_relation::bin_long & b2, std::vector<std::pair<size_t, size_t>> &Rel) {
+void binary_relation::range2(const bin_long & a1, const bin_long & a2, const bin_long & b1, const bin_long & b2, std::vector<std::pair<size_t, size_t>> &Rel, range_buffers & B) const {
+
+    Rel.clear();
+    size_t p1,p2;
+    p1 = map(a1);
+    p2 = map(a2+1)-1;
+    if(p1 > p2) return;
+    SB.range_search_2d2(p1,p2,b1,b2,B.points,B.offsets,B.ones_before_os);
+
+    for ( auto point : B.points ){
+        Rel.emplace_back(point.first,point.second);
+    }
+}
+
+void binary_relation::range(const bin_long & a1, const bin_long & a2, const bin_long & b1, const bin_long & b2, std::vector<std::pair<size_t, size_t>> &Rel) const {
 
     size_t p1,p2;
     p1 = map(a1);
@@ -166,6 +182,45 @@ void binary_relation::range(binary_relation::bin_long & a1, binary_relation::bin
     }
 }
 
+void binary_relation::build_weights(const std::vector<uint64_t> & w) {
+
+    size_t n = SB.size();
+    size_t levels = SB.max_level;
+
+    /*
+     * The i-th level of SB keeps the points stably sorted by the first i bits of the column
+     * */
+    std::vector<size_t> order(n);
+    std::vector<uint64_t> cols(n);
+    for (size_t i = 0; i < n; ++i) {
+        order[i] = i;
+        cols[i] = SB[i];
+    }
+
+    SW_map.reset();
+    SW = compressed_seq((levels+1)*n+1,0);
+    uint64_t sum = 0;
+    for (size_t l = 0; l <= levels; ++l) {
+        std::stable_sort(order.begin(), order.end(), [&cols, &levels, &l](const size_t &a, const size_t &b) -> bool {
+            return (cols[a] >> (levels - l)) < (cols[b] >> (levels - l));
+        });
+        for (size_t i = 0; i < n; ++i) {
+            sum += w[order[i]];
+            SW[l*n+i+1] = sum;
+        }
+    }
+    sdsl::util::bit_compress(SW);
+}
+
+uint64_t binary_relation::range_weight(const binary_relation::bin_long & a1, const binary_relation::bin_long & a2, const binary_relation::bin_long & b1, const binary_relation::bin_long & b2) const {
+
+    size_t p1,p2;
+    p1 = map(a1);
+    p2 = map(a2+1)-1;
+    if(p1 > p2) return 0;
+    return SB.range_sum_2d(p1,p2,b1,b2,weights());
+}
+
 binary_relation::bin_long binary_relation::labels(const size_t & a, const size_t & b) const{
 
     size_t m1 = map(a+1);
@@ -197,6 +252,20 @@ binary_relation::bin_long binary_relation::unmap(const bin_long & sufx) const {
     return xb_sel0(sufx+1)-sufx;
 }
 
+bool binary_relation::map_SW(const std::string & file) {
+
+    if(!std::ifstream(file).good())
+        return false;
+    try{
+        SW_map = std::make_shared<sdsl::read_only_mapper<>>(file);
+    }catch (const std::exception &){
+        SW_map.reset();
+        return false;
+    }
+    SW = compressed_seq();
+    return true;
+}
+
 void binary_relation::save(std::fstream & fin) const{
 
     sdsl::serialize(SB, fin);
@@ -219,6 +288,8 @@ void binary_relation::load(std::fstream & fout) {
     sdsl::load(xb_sel0,fout);
     sdsl::load(xb_sel1,fout);
     sdsl::load(xa_rank1,fout);
+    SW = compressed_seq();
+    SW_map.reset();
 
     xb_sel1 = bin_bit_vector_xb::select_1_type(&XB);
     xb_sel0 = bin_bit_vector_xb::select_0_type(&XB);
@@ -232,6 +303,7 @@ void binary_relation::print_size() {
     std::cout<<"\t SB size alphabet sigma "<<SB.sigma<<std::endl;
     std::cout<<"SL "<<sdsl::size_in_mega_bytes(SL) << std::endl;
     std::cout<<"\t SL length "<<SL.size()<< std::endl;
+    std::cout<<"SW "<<sdsl::size_in_mega_bytes(weights()) <<(SW_map ? " (mapped)" : "")<< std::endl;
     std::cout<<"XA "<<sdsl::size_in_mega_bytes(XA) << std::endl;
     std::cout<<"XB "<<sdsl::size_in_mega_bytes(XB) << std::endl;
     std::cout<<"XB rank 1 "<<sdsl::size_in_mega_bytes(xb_rank1)  << std::endl;
@@ -250,6 +322,7 @@ unsigned long long binary_relation::size_in_bytes() const {
     return
             sdsl::size_in_bytes(SB) +
             sdsl::size_in_bytes(SL) +
+            sdsl::size_in_bytes(weights()) +
 //            sdsl::size_in_bytes(XA) +
             sdsl::size_in_bytes(XB) +
 //            sdsl::size_in_bytes(xb_rank1)  +
@@ -263,6 +336,8 @@ binary_relation &binary_relation::operator=(const binary_relation & R) {
     XA = R.XA;
     SB = R.SB;
     SL = R.SL;
+    SW = R.SW;
+    SW_map = R.SW_map;
 
     xb_sel1 = bin_bit_vector_xb::select_1_type(&XB);
     xb_sel0 = bin_bit_vector_xb::select_0_type(&XB);
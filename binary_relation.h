@@ -8,27 +8,40 @@
 
 #include <utility>
 #include <vector>
+#include <memory>
 #include <sdsl/wavelet_trees.hpp>
+#include <sdsl/int_vector_mapper.hpp>
 #include <sdsl-files/wt_int.hpp>
 #include <sdsl/rrr_vector.hpp>
 #include <fstream>
+#include "utils/index_types.h"
 
 class binary_relation {
 
     public:
         unsigned int code{};
-        typedef unsigned int bin_long;
+        typedef index_long bin_long;
         typedef sdsl::updated::wt_int<> wavelet_tree;
         //typedef sdsl::wm_int<> wavelet_tree;
         typedef sdsl::rrr_vector<> bin_bit_vector_xb;
         typedef sdsl::rrr_vector<> bin_bit_vector_xa;
 //        typedef sdsl::vlc_vector<> compressed_seq;
         typedef sdsl::int_vector<> compressed_seq;
-        typedef std::pair< std::pair< unsigned int,  unsigned int> , unsigned int> point;
+        typedef std::pair< std::pair< bin_long,  bin_long> , bin_long> point;
 
     ///protected:
         wavelet_tree SB;
         compressed_seq SL;
+        /*
+         * Prefix sums of the weights of the points (number of occurrences in the text
+         * reported by each point) following the order of every level of SB
+         * */
+        compressed_seq SW;
+        /*
+         * Read-only memory map of the file of save_SW, when it is set the weights are used in
+         * place from the mapped pages and SW is empty
+         * */
+        std::shared_ptr<sdsl::read_only_mapper<>> SW_map;
 
         bin_bit_vector_xb XB;
         bin_bit_vector_xa XA;
@@ -46,10 +59,38 @@ class binary_relation {
         binary_relation(const binary_relation& );
         void build(std::vector<point>::iterator , std::vector<point>::iterator, const bin_long &, const bin_long&);
 
-        void range(binary_relation::bin_long& , binary_relation::bin_long& , binary_relation::bin_long& , binary_relation::bin_long& , std::vector< std::pair<size_t,size_t>>& );
-        void range2(binary_relation::bin_long& , binary_relation::bin_long& , binary_relation::bin_long& , binary_relation::bin_long& , std::vector< std::pair<size_t,size_t>>& );
+        void range(const bin_long& , const bin_long& , const bin_long& , const bin_long& , std::vector< std::pair<size_t,size_t>>& ) const;
+        void range2(const bin_long& , const bin_long& , const bin_long& , const bin_long& , std::vector< std::pair<size_t,size_t>>& ) const;
+        /*
+         * Scratch buffers of the range searches on SB, they can be reused among queries
+         * */
+        struct range_buffers{
+            wavelet_tree::point_vec_type points;
+            std::vector<wavelet_tree::size_type> offsets;
+            std::vector<wavelet_tree::size_type> ones_before_os;
+        };
+        /*
+         * range2 working on the buffers B, Rel is cleared first
+         * */
+        void range2(const bin_long& , const bin_long& , const bin_long& , const bin_long& , std::vector< std::pair<size_t,size_t>>&, range_buffers & B) const;
         bin_long labels(const size_t& , const size_t &) const;
         bin_long first_label_col(const size_t& ) const;
+        /*
+         * Build SW from the weights of the points, w[i] is the weight of the i-th point of SB
+         * */
+        void build_weights(const std::vector<uint64_t>& w);
+        /*
+         * True if SW was built or loaded (it is not part of the stream of save/load)
+         * */
+        bool has_weights() const { return weights().size() > 0; }
+        /*
+         * SW, or the mapped weights if they were mapped with map_SW
+         * */
+        const compressed_seq & weights() const { return SW_map ? SW_map->wrapper() : SW; }
+        /*
+         * Sum of the weights of the points in the range [a1,a2]x[b1,b2], requires has_weights()
+         * */
+        uint64_t range_weight(const bin_long& , const bin_long& , const bin_long& , const bin_long& ) const;
 
         void load(std::fstream&);
         void save(std::fstream&) const;
@@ -100,6 +141,7 @@ class binary_relation {
 
         auto get_SB_size() const{ return sdsl::size_in_bytes(SB);}
         auto get_SL_size() const{ return sdsl::size_in_bytes(SL);}
+        auto get_SW_size() const{ return sdsl::size_in_bytes(weights());}
         auto get_XA_size() const{ return sdsl::size_in_bytes(XA)+sdsl::size_in_bytes(xa_rank1);}
         auto get_XB_size() const{ return sdsl::size_in_bytes(XB)+
                                          sdsl::size_in_bytes(xb_rank1)+
@@ -112,6 +154,19 @@ class binary_relation {
         void load_SL(std::fstream&f){
                 sdsl::load(SL,f);
         }
+        void load_SW(std::fstream&f){
+                SW_map.reset();
+                sdsl::load(SW,f);
+        }
+        void save_SW(std::fstream&f) const{
+                sdsl::serialize(weights(),f);
+        }
+        /*
+         * Use the weights in place from a read-only memory map of the file written by save_SW
+         * (nothing is copied, the pages are shared by every process mapping the file), return
+         * false if the file can not be mapped
+         * */
+        bool map_SW(const std::string & file);
         void load_XA(std::fstream&f){
                 sdsl::load(XA,f);
                 xa_rank1  = bin_bit_vector_xa::rank_1_type(&XA);
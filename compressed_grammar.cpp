@@ -2,6 +2,7 @@
 // Created by inspironXV on 8/17/2018.
 //
 
+#include <fstream>
 #include "compressed_grammar.h"
 
 compressed_grammar::compressed_grammar() {
@@ -79,6 +80,17 @@ compressed_grammar::g_long compressed_grammar::offsetText(const g_long & node)co
     return select_L(m_tree.leafrank(node));
 }
 
+void compressed_grammar::prefetch_offset(const g_long & node) const{
+    auto k = m_tree.leafrank(node);
+    if(k > 0 && k <= L.low.size())
+        __builtin_prefetch(L.low.data() + ((k-1)*L.low.width())/64);
+}
+
+void compressed_grammar::prefetch_first_occ(const g_long & X) const{
+    if(X < F.size())
+        __builtin_prefetch(F.data() + (X*F.width())/64);
+}
+
 bool compressed_grammar::isTerminal(const g_long & Xi) const{
     return Y[Xi];
 }
@@ -136,9 +148,9 @@ void compressed_grammar::build(compressed_grammar::plain_grammar &grammar
 #endif
 
         sdsl::bit_vector _l(grammar.text_size() + 1, 0);
-        uint c_nodes = 0;
-        std::set<uint> M;
-        uint l_pos = 0;
+        g_long c_nodes = 0;
+        std::set<g_long> M;
+        g_long l_pos = 0;
 
         /*
          * Count the number of nodes of compact tree representation
@@ -146,7 +158,7 @@ void compressed_grammar::build(compressed_grammar::plain_grammar &grammar
          *
          * */
         grammar.dfs(grammar.get_initial_rule(), [&_l, &l_pos, &M, &c_nodes, this](rule &r) -> bool {
-            uint id = r.id;
+            g_long id = r.id;
             if (M.find(id) != M.end()) {
                 c_nodes++;
                 _l[l_pos] = true;
@@ -173,11 +185,11 @@ void compressed_grammar::build(compressed_grammar::plain_grammar &grammar
          * */
 
         sdsl::bit_vector bv(2 * c_nodes - 1, 1);
-        uint pos = 0;
+        g_long pos = 0;
         M.clear();
 
         sdsl::bit_vector z(c_nodes, 0);
-        uint i = 0, j = 1;
+        g_long i = 0, j = 1;
         sdsl::int_vector<> _f(grammar.n_rules() + 1, 0);
 
         std::ofstream xp_file("xp_file", std::ios::binary);
@@ -186,7 +198,7 @@ void compressed_grammar::build(compressed_grammar::plain_grammar &grammar
 
         grammar.dfs(grammar.get_initial_rule(), [this, &v_sq, &vs_p, &bv, &_f, &z, &M, &pos, &i, &j](const rule &r) -> bool
         {
-            uint id = r.id;
+            g_long id = r.id;
             if (M.find(id) != M.end())
             {
                 bv[pos] = false;
@@ -211,7 +223,7 @@ void compressed_grammar::build(compressed_grammar::plain_grammar &grammar
                 return false;
             }
 
-            uint n = r._rule.size();
+            g_long n = r._rule.size();
             bv[pos + n] = false;
             pos += n + 1;
             return true;
@@ -273,6 +285,7 @@ const compressed_grammar::parser_tree & compressed_grammar::get_parser_tree() co
 
 size_t compressed_grammar::size_in_bytes() const{
 
+    load_deferred_tries();
 
     return size_t(
                                sdsl::size_in_bytes(X_p) +
@@ -309,6 +322,7 @@ size_t compressed_grammar::size_in_bytes() const{
 
 //#ifdef DEBUG
 void compressed_grammar::print_size_in_bytes() const {
+    load_deferred_tries();
     std::cout<<"X_p \t"<<sdsl::size_in_mega_bytes(X_p)        <<"(bytes)"<<std::endl;
     std::cout<<"\t X_p(length) \t"<<X_p.size()<<std::endl;
     std::cout<<"\t X_p(sigma) \t"<<X_p.sigma<<std::endl;
@@ -356,6 +370,7 @@ void compressed_grammar::save(std::fstream &f) {
     sdsl::serialize(rank_L   ,f);
     sdsl::serialize(select_L ,f);
     m_tree.save(f);
+    load_deferred_tries();
     left_path.save(f);
     right_path.save(f);
 
@@ -399,6 +414,7 @@ void compressed_grammar::load(std::fstream & f) {
     m_tree.load(f);
     left_path.load(f);
     right_path.load(f);
+    deferred_tries = nullptr;
     size_t n;
     sdsl::load(n,f);
     alp.clear();
@@ -416,8 +432,8 @@ void compressed_grammar::left_most_path(){
     trie::Trie<std::vector<g_long>> left_trie;
     auto num_leaf = m_tree.leafnum(m_tree.root());
     std::map<g_long, std::vector<g_long > > paths;
-    for(int l = 0; l < num_leaf; ++l){
-        std::vector<uint > current_path;
+    for(size_t l = 0; l < num_leaf; ++l){
+        std::vector<g_long > current_path;
         auto current_leaf = m_tree.leafselect(l+1);
         auto Xj = (*this)[m_tree.pre_order(current_leaf)];
 
@@ -439,7 +455,7 @@ void compressed_grammar::left_most_path(){
 void compressed_grammar::left_most_path(const plain_grammar& grammar)
 {
     trie::Trie<std::vector<g_long>> left_trie;
-    std::vector<uint> _stack(m_tree.subtree(m_tree.root()),0);
+    std::vector<g_long> _stack(m_tree.subtree(m_tree.root()),0);
     g_long top = 0;
     std::map<g_long ,std::vector<g_long> > seconds_paths;
 
@@ -533,9 +549,9 @@ void compressed_grammar::right_most_path(const plain_grammar& grammar)
 
     m_tree.dfs_posorder(m_tree.root(),[&_stack,&top,&right_trie,&seconds_paths,this](const parser_tree::dfuds_long &node)->bool{
 
-        uint rank_ch = m_tree.childrank(node);
-        uint n_ch = m_tree.children(m_tree.parent(node));
-        uint p = m_tree.pre_order(node);
+        g_long rank_ch = m_tree.childrank(node);
+        g_long n_ch = m_tree.children(m_tree.parent(node));
+        g_long p = m_tree.pre_order(node);
         auto Xj = (*this)[p];
 
         if(m_tree.isleaf(node))
@@ -567,7 +583,7 @@ void compressed_grammar::right_most_path(const plain_grammar& grammar)
             return false;
         }
 
-        uint current = node;
+        g_long current = node;
         long pointer = (long) top-1;
         {
             std::vector<compact_trie::c_trie_long > tt;
@@ -618,20 +634,24 @@ compressed_grammar::g_long compressed_grammar::n_rules() const {
 }
 
 compressed_grammar::g_long compressed_grammar::pre_right_trie(const g_long & pre_g_tree) const {
+    load_deferred_tries();
     return left_path.preorder(pre_g_tree);
 
 
 }
 
 compressed_grammar::g_long compressed_grammar::pre_left_trie(const g_long & pre_g_tree) const {
+    load_deferred_tries();
     return right_path.preorder(pre_g_tree);
 }
 
 const compact_trie &compressed_grammar::get_right_trie() const {
+    load_deferred_tries();
     return right_path;
 }
 
 const compact_trie &compressed_grammar::get_left_trie() const {
+    load_deferred_tries();
     return left_path;
 }
 
@@ -667,8 +687,10 @@ compressed_grammar &compressed_grammar::operator=(const compressed_grammar & G)
     Y = G.Y;
     rank_Y = y_vector::rank_1_type(&Y);
     select_Y = y_vector::select_1_type(&Y);
+    G.load_deferred_tries();
     left_path = G.left_path;
     right_path = G.right_path;
+    deferred_tries = nullptr;
     ///l_occ_xp = G.l_occ_xp;
     alp = G.alp;
 
@@ -761,4 +783,29 @@ void compressed_grammar::load_mtree(std::fstream &f) {
     m_tree.load(f);
 }
 
+void compressed_grammar::defer_tries(const std::string & left_file, const std::string & right_file) {
+    deferred_tries = std::make_shared<deferred_tries_load>();
+    deferred_tries->left_file = left_file;
+    deferred_tries->right_file = right_file;
+}
+
+void compressed_grammar::load_deferred_tries() const {
+
+    if(deferred_tries == nullptr || !deferred_tries->pending.load(std::memory_order_acquire))
+        return;
+
+    std::lock_guard<std::mutex> lock(deferred_tries->m);
+    if(!deferred_tries->pending.load(std::memory_order_relaxed))
+        return;
+    {
+        std::fstream f(deferred_tries->left_file,std::ios::in|std::ios::binary);
+        left_path.load(f);
+    }
+    {
+        std::fstream f(deferred_tries->right_file,std::ios::in|std::ios::binary);
+        right_path.load(f);
+    }
+    deferred_tries->pending.store(false,std::memory_order_release);
+}
+
 
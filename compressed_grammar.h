@@ -13,6 +13,10 @@
 #include "utils/grammar.h"
 #include "trees/trie/compact_trie.h"
 #include "macros.h"
+#include "utils/index_types.h"
+#include <atomic>
+#include <memory>
+#include <mutex>
 #include <ctime>
 
 #ifdef MEM_MONITOR
@@ -27,7 +31,7 @@ class compressed_grammar {
 
     public:
         unsigned int code;
-        typedef unsigned int g_long;
+        typedef index_long g_long;
         typedef grammar plain_grammar;
         typedef  dfuds::dfuds_tree parser_tree;
 
@@ -60,9 +64,20 @@ class compressed_grammar {
         l_vector::rank_1_type rank_L;
         /*
          * Trie store the lefth/right most path of every node in the parser tree that is not a leaf
+         * (mutable, they can be loaded on the first access, see defer_tries)
          */
-        compact_trie left_path;
-        compact_trie right_path;
+        mutable compact_trie left_path;
+        mutable compact_trie right_path;
+        /*
+         * Files of the tries while their load is deferred
+         * */
+        struct deferred_tries_load{
+            std::string left_file;
+            std::string right_file;
+            std::mutex m;
+            std::atomic<bool> pending{true};
+        };
+        std::shared_ptr<deferred_tries_load> deferred_tries;
         /*
          * alphabeth
          * */
@@ -93,9 +108,9 @@ class compressed_grammar {
          * */
         const z_vector& get_Z() const{ return Z;}
 
-        std::pair<uint,uint> limits_rule(const uint &node) const{
+        std::pair<g_long,g_long> limits_rule(const g_long &node) const{
 
-                uint leaf = m_tree.leafrank(node);
+                g_long leaf = m_tree.leafrank(node);
                 if(rank_L(L.size()) == leaf)
                         return make_pair(select_L(leaf),L.size()-1);
 
@@ -105,11 +120,11 @@ class compressed_grammar {
                 return make_pair(select_L(leaf),select_L(m_tree.leafrank(m_tree.nextTreeNode(node)))-1);
         }
 
-        uint len_rule(const uint &node)const{
+        g_long len_rule(const g_long &node)const{
                 return m_tree.children(node);
         }
 
-        uint label_i_child(const uint &node,const uint& i)const{
+        g_long label_i_child(const g_long &node,const g_long& i)const{
                 return (*this)[m_tree.pre_order( m_tree.child(node,i) ) ];
         }
 
@@ -152,6 +167,13 @@ class compressed_grammar {
          * node in preorder in the grammar tree
          * */
         g_long offsetText(const g_long&) const;
+        /*
+         * Cache hints for the batched traversals of the occurrences: bring the low bits of L
+         * read by offsetText(node) and the entry of F read by select_occ(X,1)
+         * */
+        void prefetch_offset(const g_long& node) const;
+
+        void prefetch_first_occ(const g_long& X) const;
         /*
          * Return e const refernce to the parser tree
          * */
@@ -206,8 +228,8 @@ class compressed_grammar {
         compressed_grammar& operator=(const compressed_grammar&);
 
         auto get_tree_size() const {return m_tree.size_in_bytes();}
-        auto get_compact_trie_left_size()const {return left_path.size_in_bytes();}
-        auto get_compact_trie_right_size()const {return right_path.size_in_bytes();}
+        auto get_compact_trie_left_size()const {load_deferred_tries(); return left_path.size_in_bytes();}
+        auto get_compact_trie_right_size()const {load_deferred_tries(); return right_path.size_in_bytes();}
         const compressed_grammar::y_vector& get_Y()const{ return Y;}
         auto get_X_size()const {return sdsl::size_in_bytes(X_p);}
         auto get_F_size()const {return sdsl::size_in_bytes(F) + sdsl::size_in_bytes(F_inv);}
@@ -229,6 +251,12 @@ class compressed_grammar {
         void load_rtrie(std::fstream&);
         void load_alp(std::fstream&);
         void load_mtree(std::fstream&);
+        /*
+         * Load the left/right tries from these files on their first access instead of now
+         * (size_in_bytes counts as an access, so the reported space always includes them)
+         * */
+        void defer_tries(const std::string & left_file, const std::string & right_file);
+        void load_deferred_tries() const;
 
 
 
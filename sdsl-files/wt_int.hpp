@@ -85,17 +85,30 @@ template<class t_bitvector   = bit_vector,
         std::pair<size_type, std::vector<std::pair<value_type, size_type>>>
         range_search_2d2(size_type lb, size_type rb, value_type vlb, value_type vrb,
         bool report=true) const {
-            std::vector<size_type> offsets(this->m_max_level+1);
-            std::vector<size_type> ones_before_os(this->m_max_level+1);
+            std::vector<size_type> offsets;
+            std::vector<size_type> ones_before_os;
+            point_vec_type point_vec;
+            size_type cnt_answers = range_search_2d2(lb, rb, vlb, vrb, point_vec, offsets, ones_before_os, report);
+            return make_pair(cnt_answers, point_vec);
+        }
+
+        //! range_search_2d2 reporting the points in point_vec (it is cleared first) and using
+        //! offsets and ones_before_os as scratch, the buffers can be reused by the next searches
+        size_type
+        range_search_2d2(size_type lb, size_type rb, value_type vlb, value_type vrb, point_vec_type& point_vec,
+                         std::vector<size_type>& offsets, std::vector<size_type>& ones_before_os,
+                         bool report=true) const {
+            point_vec.clear();
+            offsets.resize(this->m_max_level+1);
+            ones_before_os.resize(this->m_max_level+1);
             offsets[0] = 0;
             if (vrb > (1ULL << this->m_max_level))
                 vrb = (1ULL << this->m_max_level);
             if (vlb > vrb)
-                return make_pair(0, point_vec_type());
+                return 0;
             size_type cnt_answers = 0;
-            point_vec_type point_vec;
             _range_search_2d2(lb, rb, vlb, vrb, 0, 0, this->m_size, offsets, ones_before_os, 0, point_vec, report, cnt_answers);
-            return make_pair(cnt_answers, point_vec);
+            return cnt_answers;
         }
 
         void
@@ -144,6 +157,60 @@ template<class t_bitvector   = bit_vector,
 
         }
 
+        //! Sum of the weights of the elements in [lb..rb] with values in [vlb..vrb]
+        /*! \param sums Prefix sums of the weights of the elements in the order of each level
+         *              of the tree. Level l starts at l*size() and the level max_level
+         *              holds the elements sorted by value.
+         *    \par Time complexity
+         *        $ \Order{\log |\Sigma|} $ nodes are visited, contained nodes are not expanded.
+         */
+        template<class t_sums>
+        uint64_t
+        range_sum_2d(size_type lb, size_type rb, value_type vlb, value_type vrb, const t_sums& sums) const {
+            if (vrb > (1ULL << this->m_max_level))
+                vrb = (1ULL << this->m_max_level);
+            if (vlb > vrb)
+                return 0;
+            return _range_sum_2d(lb, rb, vlb, vrb, 0, 0, this->m_size, 0, sums);
+        }
+
+        template<class t_sums>
+        uint64_t
+        _range_sum_2d(size_type lb, size_type rb, value_type vlb, value_type vrb, size_type level,
+                      size_type ilb, size_type node_size, size_type offset, const t_sums& sums) const {
+
+            if (lb > rb)
+                return 0;
+            size_type irb = ilb + (1ULL << (this->m_max_level-level));
+            if (level == this->m_max_level or (vlb <= ilb and irb-1 <= vrb)) {
+                return sums[offset + rb + 1] - sums[offset + lb];
+            }
+            size_type mid = (irb + ilb)>>1;
+
+            size_type ones_before_o    = this->m_tree_rank(offset);
+            size_type ones_before_lb   = this->m_tree_rank(offset + lb);
+            size_type ones_before_rb   = this->m_tree_rank(offset + rb + 1);
+            size_type ones_before_end  = this->m_tree_rank(offset + node_size);
+            size_type zeros_before_o   = offset - ones_before_o;
+            size_type zeros_before_lb  = offset + lb - ones_before_lb;
+            size_type zeros_before_rb  = offset + rb + 1 - ones_before_rb;
+            size_type zeros_before_end = offset + node_size - ones_before_end;
+            uint64_t sum = 0;
+            if (vlb < mid and mid) {
+                size_type nlb    = zeros_before_lb - zeros_before_o;
+                size_type nrb    = zeros_before_rb - zeros_before_o;
+                if (nrb)
+                    sum += _range_sum_2d(nlb, nrb-1, vlb, std::min(vrb,mid-1), level+1, ilb, zeros_before_end - zeros_before_o, offset + this->m_size, sums);
+            }
+            if (vrb >= mid) {
+                size_type nlb     = ones_before_lb - ones_before_o;
+                size_type nrb     = ones_before_rb - ones_before_o;
+                if (nrb)
+                    sum += _range_sum_2d(nlb, nrb-1, std::max(mid, vlb), vrb, level+1, mid, ones_before_end - ones_before_o, offset + this->m_size + (zeros_before_end - zeros_before_o), sums);
+            }
+            return sum;
+        }
+
 };
 
 }// end namespace sdsl
@@ -9,6 +9,7 @@
 #include <sdsl/int_vector.hpp>
 #include <sdsl-files/bp_support_sada.hpp>
 #include <sdsl/rrr_vector.hpp>
+#include "../utils/index_types.h"
 
 namespace dfuds {
 
@@ -18,7 +19,7 @@ namespace dfuds {
     public:
         typedef sdsl::bit_vector bv;
         typedef sdsl::updated::bp_support_sada<> parenthesis_seq;
-        typedef unsigned int dfuds_long;
+        typedef index_long dfuds_long;
 
 
 
@@ -198,9 +199,9 @@ namespace dfuds {
         }
 
         template<typename K>
-        uint find_child_dbs(const uint & node,uint & ls,uint & hs,const K &f)const{
+        dfuds_long find_child_dbs(const dfuds_long & node,dfuds_long & ls,dfuds_long & hs,const K &f)const{
 
-            uint p2 = 1;
+            dfuds_long p2 = 1;
             /*
              * f return true if p2 < value else return false             *
              * */
@@ -217,7 +218,7 @@ namespace dfuds {
 
             while(ls+1 < hs)
             {
-                uint m = (ls + hs)/2;
+                dfuds_long m = (ls + hs)/2;
                 f(m) ?  (ls = m):(hs = m-1);
             }
 
@@ -228,9 +229,9 @@ namespace dfuds {
         }
 
         template<typename K>
-        uint find_child_dbs_mirror(const uint & node,uint & ls,uint & hs,const K &f)const{
+        dfuds_long find_child_dbs_mirror(const dfuds_long & node,dfuds_long & ls,dfuds_long & hs,const K &f)const{
 
-            uint p2 = hs;
+            dfuds_long p2 = hs;
             /*
              * f return true if p2 < value else return false             *
              * */
@@ -247,7 +248,7 @@ namespace dfuds {
 
             while(ls+1 < hs)
             {
-                uint m = (ls + hs)/2;
+                dfuds_long m = (ls + hs)/2;
                 f(m) ? (hs = m) : (ls = m+1);
             }
 
@@ -397,7 +397,7 @@ const compact_patricia_tree::seq_jmp &compact_patricia_tree::get_jumps() const {
 
 compact_patricia_tree::ulong
 compact_patricia_tree::find_child_range(const compact_patricia_tree::ulong & node, const compact_patricia_tree::K & str,
-                                        const compact_patricia_tree::ulong & p,const int &cp)
+                                        const compact_patricia_tree::ulong & p,const int &cp) const
 {
 
 
@@ -445,7 +445,7 @@ compact_patricia_tree::find_child_range(const compact_patricia_tree::ulong & nod
 
 compact_patricia_tree::ulong
 compact_patricia_tree::find_child_range(const compact_patricia_tree::ulong & node, const compact_patricia_tree::revK & str,
-                                        const compact_patricia_tree::ulong & p,const int &cp) {
+                                        const compact_patricia_tree::ulong & p,const int &cp) const {
 
 
     auto childrens = m_tree.children(node);
@@ -56,8 +56,8 @@ namespace m_patricia {
         ulong size_in_bytes() const;
         void print_size_in_bytes() const;
         compact_patricia_tree& operator =(const compact_patricia_tree&);
-        ulong find_child_range(const ulong &, const K& , const ulong&, const int &);
-        ulong find_child_range(const ulong &, const revK& , const ulong& ,const int&);
+        ulong find_child_range(const ulong &, const K& , const ulong&, const int &) const;
+        ulong find_child_range(const ulong &, const revK& , const ulong& ,const int&) const;
 
 
 
@@ -0,0 +1,115 @@
+#ifndef IMPROVED_GRAMMAR_INDEX_FLAT_MAP_H
+#define IMPROVED_GRAMMAR_INDEX_FLAT_MAP_H
+
+#include <vector>
+#include <cstddef>
+#include <cstdint>
+
+/*
+ * Hash table of integer keys and values stored in a single array (open addressing with linear probing),
+ * for the scratch state of the queries.
+ *
+ * clear only advances the stamp of the table, the slots with an older stamp are empty, so a table
+ * reused by many queries keeps its array and does not allocate once it is large enough.
+ * */
+class flat_map {
+
+    public:
+        typedef uint64_t key_type;
+        typedef uint64_t value_type;
+
+    protected:
+
+        struct slot{
+            key_type key{0};
+            value_type value{0};
+            uint32_t stamp{0};
+        };
+
+        std::vector<slot> slots; // the size is 0 or a power of 2
+        uint32_t stamp{1};
+        size_t n{0};
+
+        size_t home(const key_type & key) const{
+            uint64_t h = key * 0x9E3779B97F4A7C15ULL;
+            return (size_t)(h ^ (h >> 32)) & (slots.size() - 1);
+        }
+
+        /*
+         * Double the array (at least 16 slots) and insert again the keys of the current stamp
+         * */
+        void grow(){
+            std::vector<slot> old(slots.size() < 8 ? 16 : 2*slots.size());
+            old.swap(slots);
+            size_t mask = slots.size() - 1;
+            for (auto &&s : old) {
+                if(s.stamp != stamp)
+                    continue;
+                size_t i = home(s.key);
+                while(slots[i].stamp == stamp) i = (i + 1) & mask;
+                slots[i] = s;
+            }
+        }
+
+    public:
+
+        flat_map() = default;
+        ~flat_map() = default;
+
+        /*
+         * Empty the table keeping its array
+         * */
+        void clear(){
+            n = 0;
+            if(++stamp == 0)
+            {
+                // the stamps wrapped around, the old ones could look current
+                for (auto &&s : slots) s.stamp = 0;
+                stamp = 1;
+            }
+        }
+
+        size_t size() const { return n; }
+
+        /*
+         * Copy the value of the key in v, return false if the key is not in the table
+         * */
+        bool find(const key_type & key, value_type & v) const{
+            if(slots.empty())
+                return false;
+            size_t mask = slots.size() - 1;
+            for (size_t i = home(key); slots[i].stamp == stamp; i = (i + 1) & mask)
+                if(slots[i].key == key)
+                {
+                    v = slots[i].value;
+                    return true;
+                }
+            return false;
+        }
+
+        /*
+         * Insert (key,v) and return true if the key is not in the table,
+         * otherwise set v to the value of the key and return false
+         * */
+        bool emplace(const key_type & key, value_type & v){
+            if(2*(n + 1) > slots.size())
+                grow();
+            size_t mask = slots.size() - 1;
+            size_t i = home(key);
+            for (; slots[i].stamp == stamp; i = (i + 1) & mask)
+                if(slots[i].key == key)
+                {
+                    v = slots[i].value;
+                    return false;
+                }
+            slots[i].key = key;
+            slots[i].value = v;
+            slots[i].stamp = stamp;
+            ++n;
+            return true;
+        }
+
+        size_t capacity() const { return slots.size(); }
+};
+
+#endif //IMPROVED_GRAMMAR_INDEX_FLAT_MAP_H
@@ -3,6 +3,8 @@
 //
 
 #include <algorithm>
+#include <limits>
+#include <stdexcept>
 #include <sdsl/int_vector.hpp>
 #include <sdsl/wavelet_trees.hpp>
 #include <sdsl/inv_perm_support.hpp>
@@ -12,8 +14,8 @@
 #include "grammar.h"
 
 
-typedef std::vector<std::pair<uint, uint>> rvect;
-typedef std::vector<uint> lvect;
+typedef std::vector<std::pair<rule::r_long, rule::r_long>> rvect;
+typedef std::vector<rule::r_long> lvect;
 
 grammar::grammar():_size(0),initial_rule(0) {
 
@@ -40,19 +42,26 @@ void grammar::buildRepair(const std::string &text
     mm.event(BUILD_CFG_GRAMMAR_1_RE_PAIR);
 #endif
 
-    unsigned int max_key;
+    /*
+     * The RePair compressor works on rint symbols and lengths, int unless the index is built
+     * with INDEX_64BIT (see utils/index_types.h)
+     * */
+    if(text.length() > (size_t)std::numeric_limits<rint>::max())
+        throw std::length_error("RePair: texts longer than 2^31-1 symbols need INDEX_64BIT");
+
+    rule::r_long max_key = 0;
     auto  utext = (u_char *)text.c_str();
-    int * ctext;
-    unsigned int clength;
-    unsigned int  length;
+    rint * ctext;
+    rint clength;
+    rint  length;
     length = sizeof(u_char) * text.length();
     unsigned char * symbols;
     unsigned int terminals;
-    Tdiccarray *dicc; uint cdicc;
+    Tdiccarray *dicc; rint cdicc;
     RePair compressor;
 
     compressor.compress(utext, length, &ctext, &clength, &symbols, &terminals, &dicc, &cdicc);
-    uint rules = terminals+cdicc;
+    rule::r_long rules = terminals+cdicc;
 
     repair_grammar_size = 2*cdicc+terminals;
 
@@ -89,8 +98,8 @@ void grammar::buildRepair(const std::string &text
     vector<rule::r_long> S;
     S.resize(clength);
 
-    for (uint j = 0; j < clength ; ++j) {
-        S[j] = (uint)ctext[j];
+    for (rint j = 0; j < clength ; ++j) {
+        S[j] = (rule::r_long)ctext[j];
     }
     _size += clength;
     if(rules > max_key) max_key = rules;
@@ -125,13 +134,13 @@ void grammar::buildBalRepair( const std::string &text,std::fstream & in_grammar,
     mm.event(BUILD_CFG_GRAMMAR_1_RE_PAIR);
 #endif
 
-    unsigned int max_key;
+    rule::r_long max_key = 0;
     auto  utext = (u_char *)text.c_str();
 
-    unsigned int  length;
+    size_t  length;
     length = sizeof(u_char) * text.length();
     unsigned char * symbols;
-    unsigned int terminals;
+    uint32_t terminals;
 
 
     if (!in_grammar.is_open()) {
@@ -166,9 +175,12 @@ void grammar::buildBalRepair( const std::string &text,std::fstream & in_grammar,
 
     while (!in_grammar.eof()) {
 
-        int p1, p2;
-        in_grammar.read((char *) &p1, sizeof(int));
-        in_grammar.read((char *) &p2, sizeof(int));
+        /*
+         * The files of the balanced RePair store 32-bit symbols
+         * */
+        uint32_t p1, p2;
+        in_grammar.read((char *) &p1, sizeof(p1));
+        in_grammar.read((char *) &p2, sizeof(p2));
         V.push_back(std::make_pair(p1, p2));
 
 
@@ -181,28 +193,20 @@ void grammar::buildBalRepair( const std::string &text,std::fstream & in_grammar,
     }
 
 
-    std::vector<uint> SS;
+    std::vector<rule::r_long> SS;
     while (!in_first_rule.eof()) {
-        int X;
-        in_first_rule.read((char *) &X, sizeof(int));
+        uint32_t X;
+        in_first_rule.read((char *) &X, sizeof(X));
         SS.push_back(X);
     }
     SS.pop_back();
 //
 
 //					// Variables for the compressed sequence
-    int *ctext = new int[SS.size()];
-    uint clength = SS.size();
-//            std::cout<<"S: "<<std::endl;
-    for (size_t i = 0; i < clength; ++i){
-        ctext[i] = SS[i];
-//                std::cout<<ctext[i]<<" ";
-    }
-//            std::cout<<std::endl;
-    SS.clear();
+    size_t clength = SS.size();
 
     // Variables for the dictionary rules
-    uint cdicc = V.size();
+    rule::r_long cdicc = V.size();
 
 //            RePair compressor;
 //            compressor.compress(text, length, &ctext, &clength, &symbols, &terminals, &dicc, &cdicc);
@@ -211,7 +215,7 @@ void grammar::buildBalRepair( const std::string &text,std::fstream & in_grammar,
 
 
 
-    uint rules = terminals+cdicc;
+    rule::r_long rules = terminals+cdicc;
 
     repair_grammar_size = 2*cdicc+terminals;
 
@@ -245,22 +249,15 @@ void grammar::buildBalRepair( const std::string &text,std::fstream & in_grammar,
             max_key = i+terminals;
     }
 
-    free(symbols);
+    delete [] symbols;
 //    Dictionary::destroyDicc(dicc);
     //initial rule.
-    vector<rule::r_long> S;
-    S.resize(clength);
-
-    for (uint j = 0; j < clength ; ++j) {
-        S[j] = (uint)ctext[j];
-    }
     _size += clength;
     if(rules > max_key) max_key = rules;
 
     _grammar[rules] = rule(rules,false);
-    _grammar[rules]._rule = S;
+    _grammar[rules]._rule = std::move(SS);
     initial_rule = rules;
-    free(ctext);
 #ifdef MEM_MONITOR
     auto stop = timer::now();
     CLogger::GetLogger()->model[BUILD_CFG_GRAMMAR_1_RE_PAIR] = duration_cast<microseconds>(stop-start).count();;
@@ -16,6 +16,7 @@
 #include "repair/RePair.h"
 #include <set>
 #include "../macros.h"
+#include "index_types.h"
 
 #ifdef MEM_MONITOR
 #include <ctime>
@@ -27,10 +28,10 @@ using namespace std::chrono;
 
 struct rule{
 
-    typedef unsigned int r_long;
+    typedef index_long r_long;
     r_long id;
     bool terminal;
-    uint node;
+    r_long node;
     /*
      * Rule production
      * */
@@ -88,10 +89,10 @@ struct rule{
 struct rule_trav{
 
     rule* rules;
-    uint* rule_position;
-    uint* last_processed;
-    uint* label_last_processed;
-    uint* len_rule;
+    rule::r_long* rule_position;
+    rule::r_long* last_processed;
+    rule::r_long* label_last_processed;
+    rule::r_long* len_rule;
 
     int level;
     uint read;
@@ -117,14 +118,14 @@ struct rule_trav{
 //        }
 //    };
 
-    rule_trav(uint _id, uint len,uint node, int max){
+    rule_trav(rule::r_long _id, rule::r_long len,rule::r_long node, int max){
 
 
         rules = new rule[max];
-        rule_position = new uint[max];
-        last_processed = new uint[max];
-        label_last_processed = new uint[max];
-        len_rule = new uint[max];
+        rule_position = new rule::r_long[max];
+        last_processed = new rule::r_long[max];
+        label_last_processed = new rule::r_long[max];
+        len_rule = new rule::r_long[max];
 
         for (int i = 0; i < max; ++i) {
             rule_position[i] = 0;
@@ -0,0 +1,126 @@
+#ifndef IMPROVED_GRAMMAR_INDEX_HEAVY_OCC_H
+#define IMPROVED_GRAMMAR_INDEX_HEAVY_OCC_H
+
+#include <vector>
+#include <fstream>
+#include <sdsl/sd_vector.hpp>
+#include <sdsl/int_vector.hpp>
+#include "index_types.h"
+
+/*
+ * Materialized text positions of a set of rules (the heavy rules).
+ *
+ * R marks the heavy rules and the k-th one (in increasing order of rule id) has its sorted
+ * positions p stored in P as k*n + p, so all the lists share a single Elias-Fano sequence.
+ * start[k] is the number of positions of the heavy rules before the k-th one.
+ * */
+class heavy_occ {
+
+    public:
+        typedef sdsl::sd_vector<> s_vector;
+
+    protected:
+
+        uint64_t n{0};
+        s_vector R;
+        s_vector::rank_1_type rank_R;
+        s_vector P;
+        s_vector::select_1_type select_P;
+        sdsl::int_vector<> start;
+
+        void bind(){
+            rank_R = s_vector::rank_1_type(&R);
+            select_P = s_vector::select_1_type(&P);
+        }
+
+    public:
+
+        heavy_occ() { bind(); }
+        ~heavy_occ() = default;
+
+        heavy_occ(const heavy_occ & H):n(H.n),R(H.R),P(H.P),start(H.start){ bind(); }
+        heavy_occ& operator=(const heavy_occ & H){
+            n = H.n;
+            R = H.R;
+            P = H.P;
+            start = H.start;
+            bind();
+            return *this;
+        }
+
+        /*
+         * lists contains the rules (in increasing order, less than n_rules) with their sorted
+         * positions in a text of length _n
+         * */
+        void build(const std::vector<std::pair<uint64_t,std::vector<index_long>>> & lists, const uint64_t & n_rules, const uint64_t & _n){
+            n = _n;
+            start = sdsl::int_vector<>(lists.size()+1,0);
+
+            std::vector<uint64_t> rules;
+            std::vector<uint64_t> pos;
+            uint64_t k = 0;
+            for (auto &&l : lists)
+            {
+                rules.push_back(l.first);
+                for (auto &&p : l.second)
+                    pos.push_back(k*n + p);
+                start[++k] = pos.size();
+            }
+            sdsl::util::bit_compress(start);
+
+            sdsl::bit_vector B(n_rules,0);
+            for (auto &&X : rules)
+                B[X] = true;
+            R = s_vector(B);
+            P = s_vector(pos.begin(),pos.end());
+            bind();
+        }
+
+        bool empty() const { return start.size() < 2; }
+
+        /*
+         * Return true if X is a heavy rule, k is set to its position among them
+         * */
+        bool find(const uint64_t & X, uint64_t & k) const{
+            if(empty() || X >= R.size() || !R[X])
+                return false;
+            k = rank_R(X);
+            return true;
+        }
+
+        uint64_t n_occ(const uint64_t & k) const { return start[k+1] - start[k]; }
+
+        /*
+         * Report p + offset for every position p of the k-th heavy rule, stops if f returns false
+         * */
+        template<typename F>
+        bool report(const uint64_t & k, const long & offset, const F & f) const{
+            uint64_t base = k*n;
+            for (uint64_t i = start[k] + 1; i <= start[k+1]; ++i)
+                if(!f((index_long)(select_P(i) - base + offset)))
+                    return false;
+            return true;
+        }
+
+        void save(std::fstream & f) const{
+            sdsl::write_member(n,f);
+            sdsl::serialize(R,f);
+            sdsl::serialize(P,f);
+            sdsl::serialize(start,f);
+        }
+
+        void load(std::fstream & f){
+            sdsl::read_member(n,f);
+            sdsl::load(R,f);
+            sdsl::load(P,f);
+            sdsl::load(start,f);
+            bind();
+        }
+
+        size_t size_in_bytes() const{
+            return sizeof(n) + sdsl::size_in_bytes(R) + sdsl::size_in_bytes(rank_R) +
+                   sdsl::size_in_bytes(P) + sdsl::size_in_bytes(select_P) + sdsl::size_in_bytes(start);
+        }
+};
+
+#endif //IMPROVED_GRAMMAR_INDEX_HEAVY_OCC_H
@@ -0,0 +1,21 @@
+#ifndef IMPROVED_GRAMMAR_INDEX_INDEX_TYPES_H
+#define IMPROVED_GRAMMAR_INDEX_INDEX_TYPES_H
+
+#include <cstdint>
+
+/*
+ * Width of the text positions, rule ids, parser tree nodes and grid coordinates of the index
+ * (grammar, compressed grammar, grid, queries and reported occurrences). 32 bits by default,
+ * building with -DUSE_64BIT_INDEX=ON (INDEX_64BIT) makes them 64 bits.
+ *
+ * The built-in RePair compressor (utils/repair) follows it with its rint type, int by default,
+ * long long with INDEX_64BIT. Without INDEX_64BIT grammar::buildRepair throws std::length_error
+ * on texts longer than 2^31-1 symbols.
+ * */
+#ifdef INDEX_64BIT
+typedef uint64_t index_long;
+#else
+typedef unsigned int index_long;
+#endif
+
+#endif //IMPROVED_GRAMMAR_INDEX_INDEX_TYPES_H
@@ -0,0 +1,127 @@
+#ifndef IMPROVED_GRAMMAR_INDEX_KARP_RABIN_H
+#define IMPROVED_GRAMMAR_INDEX_KARP_RABIN_H
+
+#include <fstream>
+#include <random>
+#include <sdsl/int_vector.hpp>
+
+/*
+ * Karp-Rabin fingerprints of the rule expansions, h(s) = sum (s[i]+1) * B^(|s|-1-i) mod 2^61-1
+ * for a base B drawn from a seed (fixed by default, so two builds of the same grammar have the same
+ * fingerprints). fp[X] is the fingerprint of the expansion of the rule X and len[X] its length.
+ *
+ * Equal fingerprints mean equal strings with high probability (about |s|/2^61 of a false match).
+ * */
+class karp_rabin {
+
+    public:
+        static const uint64_t P = (1ULL << 61) - 1;
+        static constexpr uint64_t default_seed = 0x2545F4914F6CDD1DULL;
+
+    protected:
+
+        uint64_t B{0};
+        uint64_t seed{0};
+        sdsl::int_vector<> fp;
+        sdsl::int_vector<> len;
+
+    public:
+
+        karp_rabin() = default;
+        ~karp_rabin() = default;
+
+        static uint64_t add(const uint64_t & a, const uint64_t & b){
+            uint64_t s = a + b;
+            return (s >= P)? s - P : s;
+        }
+
+        static uint64_t mul(const uint64_t & a, const uint64_t & b){
+            __uint128_t m = (__uint128_t)a * b;
+            uint64_t s = (uint64_t)(m & P) + (uint64_t)(m >> 61);
+            return (s >= P)? s - P : s;
+        }
+
+        uint64_t pow(uint64_t e) const{
+            uint64_t r = 1, b = B;
+            for (; e > 0; e >>= 1)
+            {
+                if(e & 1) r = mul(r,b);
+                b = mul(b,b);
+            }
+            return r;
+        }
+
+        static uint64_t symbol(const unsigned char & c){ return (uint64_t)c + 1; }
+        /*
+         * Fingerprint of s.c from the one of s
+         * */
+        uint64_t append(const uint64_t & h, const unsigned char & c) const{ return add(mul(h,B),symbol(c)); }
+        /*
+         * Fingerprint of c.s from the one of s, pw = B^|s|
+         * */
+        uint64_t prepend(const uint64_t & h, const unsigned char & c, const uint64_t & pw) const{ return add(mul(symbol(c),pw),h); }
+        /*
+         * Fingerprint of s1.s2 from the ones of s1 and s2
+         * */
+        uint64_t concat(const uint64_t & h1, const uint64_t & h2, const uint64_t & len2) const{
+            return add(mul(h1,pow(len2)),h2);
+        }
+
+        /*
+         * Empty fingerprints for n_rules rules with the base drawn from the seed s
+         * */
+        void reset(const uint64_t & n_rules, const uint64_t & s){
+            seed = s;
+            std::mt19937_64 gen(s);
+            B = 256 + gen() % (P - 512);
+            fp = sdsl::int_vector<>(n_rules,0,61);
+            len = sdsl::int_vector<>(n_rules,0,64);
+        }
+
+        void clear(){
+            B = 0;
+            seed = 0;
+            fp = sdsl::int_vector<>();
+            len = sdsl::int_vector<>();
+        }
+
+        void set(const uint64_t & X, const uint64_t & h, const uint64_t & l){
+            fp[X] = h;
+            len[X] = l;
+        }
+
+        /*
+         * Compress the lengths once all the rules are set
+         * */
+        void compress(){ sdsl::util::bit_compress(len); }
+
+        bool empty() const { return fp.empty(); }
+
+        uint64_t base() const { return B; }
+
+        uint64_t get_seed() const { return seed; }
+
+        uint64_t operator[](const uint64_t & X) const { return fp[X]; }
+
+        uint64_t length(const uint64_t & X) const { return len[X]; }
+
+        void save(std::fstream & f) const{
+            sdsl::write_member(B,f);
+            sdsl::write_member(seed,f);
+            sdsl::serialize(fp,f);
+            sdsl::serialize(len,f);
+        }
+
+        void load(std::fstream & f){
+            sdsl::read_member(B,f);
+            sdsl::read_member(seed,f);
+            sdsl::load(fp,f);
+            sdsl::load(len,f);
+        }
+
+        size_t size_in_bytes() const{
+            return sizeof(B) + sizeof(seed) + sdsl::size_in_bytes(fp) + sdsl::size_in_bytes(len);
+        }
+};
+
+#endif //IMPROVED_GRAMMAR_INDEX_KARP_RABIN_H
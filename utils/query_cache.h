@@ -0,0 +1,15 @@
+#ifndef IMPROVED_GRAMMAR_INDEX_QUERY_CACHE_H
+#define IMPROVED_GRAMMAR_INDEX_QUERY_CACHE_H
+
+#include <string>
+#include "sharded_lru.h"
+
+/*
+ * Bounded LRU cache of query results keyed by strings (pattern pieces or complete patterns),
+ * shared by the threads of the queries. The caller gives the cost of every entry
+ * (see sharded_lru).
+ * */
+template<typename V>
+using query_cache = sharded_lru<std::string, V>;
+
+#endif //IMPROVED_GRAMMAR_INDEX_QUERY_CACHE_H
@@ -30,18 +30,18 @@ Chile. Blanco Encalada 2120, Santiago, Chile. gnavarro@dcc.uchile.cl
 #include "RePair.h"
 
 int 
-RePair::compress(unsigned char *text, unsigned int length,
-			     int **ctext, unsigned int *clength,
+RePair::compress(unsigned char *text, rint length,
+			     rint **ctext, rint *clength,
 			     unsigned char **symbols, unsigned int *csymbols,
-			     Tdiccarray **rules, unsigned int *crules)
+			     Tdiccarray **rules, rint *crules)
 {
 	prepare (text,length);
 	repair();
     
 	// Obtaining the compressed sequence
-	(*ctext) = (int*)malloc(c*sizeof(int));
+	(*ctext) = (rint*)malloc(c*sizeof(rint));
 	
-	int i = 0, x = 0;
+	rint i = 0, x = 0;
 	
 	while (i<u)
 	{ 
@@ -51,16 +51,16 @@ RePair::compress(unsigned char *text, unsigned int length,
 		if ((i < u) && (C[i] < 0)) i = -C[i]-1;
 	}
 	
-	*clength = (unsigned long)c;
+	*clength = c;
 	free(C); free(L); free(chars);
 	Heap::destroyHeap(&Heap);
 	Hash::destroyHash(&Hash);
 	
 	// Linking results with function parameters
 	*symbols = map;
-	*csymbols = (unsigned long)alph;
+	*csymbols = (unsigned int)alph;
 	*rules = &Dicc; 
-	*crules = (unsigned long)(n-alph);
+	*crules = n-alph;
 	
 	return 0;
 }
@@ -69,7 +69,7 @@ RePair::compress(unsigned char *text, unsigned int length,
 int 
 RePair::repair()
 {
-	int oid,id,cpos;
+	rint oid,id,cpos;
 	Trecord *rec,*orec;
 	Tpair pair;
 
@@ -84,10 +84,10 @@ RePair::repair()
 		
 		orec = &Rec.records[oid];
 		cpos = orec->cpos;
-		unsigned int ppos = 0;
+		rint ppos = 0;
 		
 		// Adding a new rule to the dictionary
-		int lrule = 0;
+		rint lrule = 0;
 		
 		if (orec->pair.left < alph) lrule++; 
 		else lrule += Dicc.rules[orec->pair.left-alph].len;
@@ -100,18 +100,18 @@ RePair::repair()
 		
 		if (PRNP) 
 		{ 
-			printf("Chosen pair %i = (",n);
+			printf("Chosen pair %lld = (",(long long)n);
 			prnSym(orec->pair.left);
 			printf(",");
 			prnSym(orec->pair.right);
-			printf(") (%i occs)\n",orec->freq);
+			printf(") (%lld occs)\n",(long long)orec->freq);
 		}
 	
 		while (cpos != -1)
 		{ 
 			ppos = cpos;
 			
-			int ant,sgte,ssgte; 
+			rint ant,sgte,ssgte; 
 			// replacing bc->e in abcd, b = cpos, c = sgte, d = ssgte
 			if (C[cpos+1] < 0) sgte = -C[cpos+1]-1; 
 			else sgte = cpos+1; 
@@ -227,7 +227,7 @@ RePair::repair()
 			cpos = orec->cpos;
 		}
 		
-		if (nrule.occ > (int)ppos) nrule.occ = ppos;
+		if (nrule.occ > ppos) nrule.occ = ppos;
 		Dictionary::insertRule (&Dicc, nrule);
 		
 		if (PRNC) prnC();
@@ -243,15 +243,15 @@ RePair::repair()
 
 
 void
-RePair::prepare(unsigned char *text, int len)
+RePair::prepare(unsigned char *text, rint len)
 {
-    int i,id;
+    rint i,id;
     Tpair pair;
     c = u = len;
-    C = (int*)malloc(u*sizeof(int));
+    C = (rint*)malloc(u*sizeof(rint));
     alph = 0;	
 	
-    chars = (int*)malloc(sizeof(int)*256);
+    chars = (rint*)malloc(sizeof(rint)*256);
     for (i=0;i<256;i++) { chars[i] = -1; }
 	
     map = (unsigned char*)malloc(sizeof(unsigned char)*256);
@@ -294,7 +294,7 @@ RePair::prepare(unsigned char *text, int len)
 		L[i].prev = -id-1;
 		Rec.records[id].cpos = i;
 		
-		if (PRNL && (i%10000 == 0)) printf ("Processed %i chars\n",i);
+		if (PRNL && (i%10000 == 0)) printf ("Processed %lld chars\n",(long long)i);
 		
 		if (i == 912971438-1) { id = i; }
 	}
@@ -303,16 +303,16 @@ RePair::prepare(unsigned char *text, int len)
 }
 
 void 
-RePair::prnSym(int c)
+RePair::prnSym(rint c)
 {
-	if (c < alph) printf("%c", map[c]); else printf ("%i",c);
+	if (c < alph) printf("%c", map[c]); else printf ("%lld",(long long)c);
 }
 	
 void 
 RePair::prnC(void)
 {
-	int i = 0;
-	printf ("C[1..%i] = ",c);
+	rint i = 0;
+	printf ("C[1..%lld] = ",(long long)c);
 	
     while (i<u)
 	{ 
@@ -329,7 +329,7 @@ RePair::prnC(void)
 void 
 RePair::prnRec(void)
 {
-	int i;
+	rint i;
 	printf ("Active pairs:\n");
 	
 	for (i=0;i<Rec.size;i++)
@@ -338,7 +338,7 @@ RePair::prnRec(void)
 		prnSym(Rec.records[i].pair.left);
 		printf (",");
 		prnSym(Rec.records[i].pair.right);
-		printf ("), %i occs\n", Rec.records[i].freq);
+		printf ("), %lld occs\n", (long long)Rec.records[i].freq);
 	}
 	
     printf ("\n");
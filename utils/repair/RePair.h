@@ -55,30 +55,30 @@ using namespace std;
 class RePair
 {
 public:
-	int compress(unsigned char *text, unsigned int length,
-			    int **ctext, unsigned int *clength,
+	int compress(unsigned char *text, rint length,
+			    rint **ctext, rint *clength,
 			    unsigned char **symbols, unsigned int *csymbols,
-			    Tdiccarray **rules, unsigned int *crules);
+			    Tdiccarray **rules, rint *crules);
 
 private:
-	int u;		// |text| and later current |C| with gaps
-	int *C; 		// compressed text
-	int c;  		// real |C|
-	int alph;	// max used terminal symbol
-	int n; 		// |R|
+	rint u;		// |text| and later current |C| with gaps
+	rint *C; 		// compressed text
+	rint c;  		// real |C|
+	rint alph;	// max used terminal symbol
+	rint n; 		// |R|
 	Tlist *L; 	// |L| = c;
 	Thash Hash; 	// hash table of pairs
 	Theap Heap; 	// special heap of pairs
 	Trarray Rec; 	// records
 	Tdiccarray Dicc;	// compressed dictionary
 
-	int *chars;
+	rint *chars;
 	unsigned char *map;
 
 	int repair();
 
-	void prepare(unsigned char *text, int len);
-	void prnSym(int c);
+	void prepare(unsigned char *text, rint len);
+	void prnSym(rint c);
 	void prnC(void);
 	void prnRec(void);
 
@@ -29,21 +29,21 @@ Chile. Blanco Encalada 2120, Santiago, Chile. gnavarro@dcc.uchile.cl
 #include "arrayG.h"
 #include "records.h"
 
-int 
-ArrayG::insertArray (Tarray *A, int pair)
-   { int *npairs;
-     int max,size,i,pos,id,fst;
+rint 
+ArrayG::insertArray (Tarray *A, rint pair)
+   { rint *npairs;
+     rint max,size,i,pos,id,fst;
      Trecord *rec = ((Trarray*)A->Rec)->records;
      if (A->size == A->maxsize)
 	{ if (A->maxsize == 0)
 	     { A->maxsize = A->minsize;
-	       A->pairs = (int*) malloc (A->maxsize * sizeof(int));
+	       A->pairs = (rint*) malloc (A->maxsize * sizeof(rint));
 	       A->fst = 0;
 	     }
 	  else
 	     { max = A->maxsize;
 	       A->maxsize /= A->factor;
-	       npairs = (int*) malloc (A->maxsize * sizeof(int));
+	       npairs = (rint*) malloc (A->maxsize * sizeof(rint));
 	       size = A->size;
 	       fst = A->fst;
 	       for (i=0;i<size;i++)
@@ -65,8 +65,8 @@ ArrayG::insertArray (Tarray *A, int pair)
 
 void 
 ArrayG::deleteArray (Tarray *A)
-   { int *npairs;
-     int size,i,id,max,fst;
+   { rint *npairs;
+     rint size,i,id,max,fst;
      Trecord *rec = ((Trarray*)A->Rec)->records;
      A->fst = (A->fst+1) % A->maxsize;
      A->size--;
@@ -80,7 +80,7 @@ ArrayG::deleteArray (Tarray *A)
 	      (A->maxsize * A->factor >= A->minsize))
 	{ max = A->maxsize;
 	  A->maxsize *= A->factor;
-	  npairs = (int*) malloc (A->maxsize * sizeof(int));
+	  npairs = (rint*) malloc (A->maxsize * sizeof(rint));
 	  size = A->size;
 	  fst = A->fst;
 	  for (i=0;i<size;i++)
@@ -96,7 +96,7 @@ ArrayG::deleteArray (Tarray *A)
    }
 
 Tarray 
-ArrayG::createArray(void *Rec, float factor, int minsize)
+ArrayG::createArray(void *Rec, float factor, rint minsize)
    { Tarray A;
      A.Rec = Rec;
      A.pairs = NULL;
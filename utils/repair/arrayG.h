@@ -31,12 +31,12 @@ Chile. Blanco Encalada 2120, Santiago, Chile. gnavarro@dcc.uchile.cl
 #include "basics.h"
 
 typedef struct
-   { int *pairs; // identifiers
-     int maxsize;  
-     int size;
-     int fst; // first of circular array
+   { rint *pairs; // identifiers
+     rint maxsize;  
+     rint size;
+     rint fst; // first of circular array
      float factor;
-     int minsize;
+     rint minsize;
      void *Rec; // records
    } Tarray;
 
@@ -45,12 +45,12 @@ class ArrayG
 {
 public:
 	// creates empty array
-	static Tarray createArray(void *Rec, float factor, int minsize);
+	static Tarray createArray(void *Rec, float factor, rint minsize);
 	// destroys A
 	static void destroyArray (Tarray *A);
 
 	// inserts pair in A, returns pos
-	static int insertArray (Tarray *A, int pair);
+	static rint insertArray (Tarray *A, rint pair);
 	 // deletes last cell in A
 	static void deleteArray (Tarray *A); 
 };
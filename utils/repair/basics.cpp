@@ -26,8 +26,11 @@ Chile. Blanco Encalada 2120, Santiago, Chile. gnavarro@dcc.uchile.cl
 
 #include <stdlib.h>
 #include <stdio.h>
+#include "basics.h"
+#undef malloc
+#undef realloc
 
-int NullFreq = 1 << (8*sizeof(int)-1);
+rint NullFreq = (rint)(1ULL << (8*sizeof(rint)-1));
 
 void *myMalloc (long long n)
 
@@ -53,9 +56,9 @@ void *myRealloc (void *p, long long n)
     return p;
   }
 
-int blog (int x)
+rint blog (rint x)
 
-   { int l=0;
+   { rint l=0;
      while (x) { x>>=1; l++; }
      return l;
    }
@@ -33,12 +33,21 @@ void *myRealloc (void *p, long long n);
 #define malloc(n) myMalloc(n)
 #define realloc(p,n) myRealloc(p,n)
 
+	// symbols, positions and counts, 64 bits when the index is built with
+	// INDEX_64BIT so that texts over 2^31-1 symbols can be compressed
+
+#ifdef INDEX_64BIT
+typedef long long rint;
+#else
+typedef int rint;
+#endif
+
 typedef struct
-  { int left,right;
+  { rint left,right;
   } Tpair;
 
-extern int NullFreq;
+extern rint NullFreq;
 
-int blog (int x); // bits to represent x
+rint blog (rint x); // bits to represent x
 
 #endif
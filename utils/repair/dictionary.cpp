@@ -29,9 +29,9 @@ Chile. Blanco Encalada 2120, Santiago, Chile. gnavarro@dcc.uchile.cl
 #include <stdlib.h>
 #include "dictionary.h"
 
-int 
+rint 
 Dictionary::insertRule (Tdiccarray *Dicc, Trule rule)
-   { int id;
+   { rint id;
      Trule *nrule;
      if (Dicc->size == Dicc->maxsize)
 	{ if (Dicc->maxsize == 0)
@@ -52,7 +52,7 @@ Dictionary::insertRule (Tdiccarray *Dicc, Trule rule)
 
 
 Tdiccarray 
-Dictionary::createDicc (float factor, int minsize)
+Dictionary::createDicc (float factor, rint minsize)
    { Tdiccarray Dicc;
      Dicc.rules = NULL;
      Dicc.maxsize = 0;
@@ -34,16 +34,16 @@ Chile. Blanco Encalada 2120, Santiago, Chile. gnavarro@dcc.uchile.cl
 
 typedef struct
    { Tpair rule; // left and righ component
-     int len;	 // rule length
-     int occ;	 // first ocurrence
+     rint len;	 // rule length
+     rint occ;	 // first ocurrence
    } Trule;
 
 typedef struct
    { Trule *rules; 
-     int maxsize;  
-     int size;
+     rint maxsize;  
+     rint size;
      float factor;
-     int minsize;
+     rint minsize;
    } Tdiccarray;
 
 // contents can be accessed as Dic.rules[0..Dicc.size-1]
@@ -51,9 +51,9 @@ class Dictionary
 {
 public:
 	// inserts rule in Dicc, returns id
-	static int insertRule (Tdiccarray *Dicc, Trule rule); 
+	static rint insertRule (Tdiccarray *Dicc, Trule rule); 
 	 // creates empty dictionary
-	static Tdiccarray createDicc (float factor, int minsize);
+	static Tdiccarray createDicc (float factor, rint minsize);
 	// destroys Rec
 	static void destroyDicc (Tdiccarray *Dicc);
 };
@@ -34,10 +34,24 @@ Chile. Blanco Encalada 2120, Santiago, Chile. gnavarro@dcc.uchile.cl
 #include <stdlib.h>
 #include "hash.h"
 
-int 
+	// initial probe of pair p; 64-bit symbols do not fit side by side in
+	// a relong, so then they are mixed with LPRIME instead
+
+static inline rint
+hashPair (Tpair p, rint maxpos)
+  {
+#ifdef INDEX_64BIT
+    relong u = ((relong)p.left*LPRIME + (relong)p.right) * LPRIME;
+    return (rint)((u ^ (u >> 32)) & (relong)maxpos);
+#else
+    relong u = ((relong)p.left)<<(8*sizeof(rint)) | (relong)p.right;
+    return ((PRIME*u) >> (8*sizeof(rint))) & maxpos;
+#endif
+  }
+
+rint 
 Hash::searchHash (Thash H, Tpair p) 
-  { relong u = ((relong)p.left)<<(8*sizeof(int)) | (relong)p.right;
-	int k = ((PRIME*u) >> (8*sizeof(int))) & H.maxpos;
+  { rint k = hashPair (p,H.maxpos);
     Trecord *recs = H.Rec->records;
     while (H.table[k] != -1) 
       {	if ((H.table[k] >= 0) && 
@@ -49,7 +63,7 @@ Hash::searchHash (Thash H, Tpair p)
   }
 
 void 
-Hash::deleteHash (Thash *H, int id) 
+Hash::deleteHash (Thash *H, rint id) 
   // deletes H->Rec[id].pair from hash
   { Trecord *rec = H->Rec->records;
     H->table[rec[id].kpos] = -2;
@@ -57,43 +71,42 @@ Hash::deleteHash (Thash *H, int id)
   }
 
 Thash 
-Hash::createHash (int maxpos, Trarray *Rec)
+Hash::createHash (rint maxpos, Trarray *Rec)
   // creates new empty hash table
   { Thash H;
-    int i;
+    rint i;
 	// upgrade maxpos to the next value of the form (1<<smth)-1
     while (maxpos & (maxpos-1)) maxpos &= maxpos-1;
     maxpos = (maxpos-1)<<1 | 1;  // avoids overflow if maxpos = 1<<31
     H.maxpos = maxpos;
     H.used = 0;
-    H.table = (int*)malloc((1+maxpos)*sizeof(int));
+    H.table = (rint*)malloc((1+maxpos)*sizeof(rint));
     for (i=0;i<=maxpos;i++) H.table[i] = -1;
     H.Rec = Rec;
     return H;
   }
   
-int 
+rint 
 Hash::finsertHash (Thash H, Tpair p) 
   // inserts w/o resizing, assumes there is space
   // does not update used field
   // note can reuse marked deletions
-  { relong u = ((relong)p.left)<<(8*sizeof(int)) | (relong)p.right;
-	int k = ((PRIME*u) >> (8*sizeof(int))) & H.maxpos;
+  { rint k = hashPair (p,H.maxpos);
     while (H.table[k] >= 0) k = (k+1) & H.maxpos;
     return k;
   }
   
 void 
-Hash::insertHash (Thash *H, int id) 
+Hash::insertHash (Thash *H, rint id) 
   // inserts H->Rec[id].pair in hash 
   // assumes key is not present
   // sets ptr from Rec to hash as well
-  { int k;
+  { rint k;
     Trecord *rec = H->Rec->records;
     if (H->used > H->maxpos * factor) // resize
 	{ Thash newH = createHash((H->maxpos<<1)|1,H->Rec);
-	  int i;
-	  int *tab = H->table;
+	  rint i;
+	  rint *tab = H->table;
 	  for (i=0;i<=H->maxpos;i++)
 	      if (tab[i] >= 0) // also removes marked deletions
 		 { k = finsertHash (newH,rec[tab[i]].pair);
@@ -119,7 +132,7 @@ Hash::destroyHash (Thash *H)
   }
  
 void 
-Hash::hashRepos (Thash *H, int id)
+Hash::hashRepos (Thash *H, rint id)
   { Trecord *rec = H->Rec->records;
     H->table[rec[id].kpos] = id;
   }
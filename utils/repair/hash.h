@@ -40,9 +40,9 @@ typedef unsigned long long relong;
 #define PRIME 2013686449
 
 typedef struct
-  { int *table;
-    int maxpos; // of the form (1<<smth)-1
-    int used;
+  { rint *table;
+    rint maxpos; // of the form (1<<smth)-1
+    rint used;
     Trarray *Rec; // records
   } Thash;
 
@@ -50,21 +50,21 @@ class Hash
 {
 public:
 	// creates new empty hash table
-	static Thash createHash (int maxpos, Trarray *Rec); 
+	static Thash createHash (rint maxpos, Trarray *Rec); 
 	// destroys hash table, not heap nor list
 	static void destroyHash (Thash *H); 
 	// inserts H->Rec[id].pair in hash 
 	// assumes it is not already there
 	// sets ptr from Rec to hash as well
-	static void insertHash (Thash *H, int id);
+	static void insertHash (Thash *H, rint id);
 	// deletes H->Rec[id].pair from hash
-	static void deleteHash (Thash *H, int id);
+	static void deleteHash (Thash *H, rint id);
 	// returns id, -1 if not existing
-	static int searchHash (Thash H, Tpair p);
+	static rint searchHash (Thash H, Tpair p);
 	 // repositions pair
-	static void hashRepos (Thash *H, int id);
+	static void hashRepos (Thash *H, rint id);
 
-	static int finsertHash (Thash H, Tpair p) ;
+	static rint finsertHash (Thash H, Tpair p) ;
 };
 
 #endif
@@ -33,11 +33,11 @@ Chile. Blanco Encalada 2120, Santiago, Chile. gnavarro@dcc.uchile.cl
 static int PRNH = 0;
 
 Theap 
-Heap::createHeap (int u, Trarray *Rec, float factor, int minsize) 
+Heap::createHeap (rint u, Trarray *Rec, float factor, rint minsize) 
   // creates new empty heap
   // minsize, factor: space/time tradeoffs
   { Theap H;
-    int i;
+    rint i;
     H.sqrtu = 2;
     while (H.sqrtu * H.sqrtu < u) H.sqrtu++;
     H.infreq = (Tarray*) malloc(H.sqrtu * sizeof(Tarray));
@@ -59,7 +59,7 @@ Heap::createHeap (int u, Trarray *Rec, float factor, int minsize)
 void 
 Heap::destroyHeap (Theap *H) 
   // destroys H
-  { int i;
+  { rint i;
     for (i=1;i<H->sqrtu;i++) ArrayG::destroyArray(&H->infreq[i]);
     free (H->infreq); H->infreq = NULL;
     free (H->freq); H->freq = NULL;
@@ -69,8 +69,8 @@ Heap::destroyHeap (Theap *H)
   }
 
 void 
-Heap::move (Tarray A, int i, int j, Trecord *rec)
-  { int id = A.pairs[j];
+Heap::move (Tarray A, rint i, rint j, Trecord *rec)
+  { rint id = A.pairs[j];
     A.pairs[i] = id;
     rec[id].hpos = i;
   }
@@ -78,15 +78,15 @@ Heap::move (Tarray A, int i, int j, Trecord *rec)
 void 
 Heap::prnH (Theap *H)
   { Thfreq *f;
-    static int X = 0;
-    int prevf = 1<<30;
-    int fp = H->largest;
+    static rint X = 0;
+    rint prevf = 1<<30;
+    rint fp = H->largest;
     if (fp == -1) return;
     X++;
-    printf ("Heap %i = \n",X);
+    printf ("Heap %lld = \n",(long long)X);
     while (fp != -1)
        { f = &H->ff[fp];
-         printf ("freq=%i, elems=%i\n",f->freq,f->elems);
+         printf ("freq=%lld, elems=%lld\n",(long long)f->freq,(long long)f->elems);
 	 if (prevf <= f->freq)
 	    { fp++; }
 	 prevf = f->freq;
@@ -95,14 +95,14 @@ Heap::prnH (Theap *H)
   }
 
 void 
-Heap::incFreq (Theap *H, int id) 
+Heap::incFreq (Theap *H, rint id) 
   // inc freq of pair Rec[id]
   { Trecord *rec = H->Rec->records;
-    int freq = rec[id].freq++;
-    int hpos = rec[id].hpos;
+    rint freq = rec[id].freq++;
+    rint hpos = rec[id].hpos;
     Thnode *p;
     Thfreq *f,*lf;
-    int fp,lfp;
+    rint fp,lfp;
 if (PRNH) prnH(H);
     if (freq >= H->sqrtu) // high freq part, hpos is a ptr within freq
        { p = &H->freq[hpos];
@@ -192,14 +192,14 @@ if (PRNH) prnH(H);
   }
 
 void 
-Heap::decFreq (Theap *H, int id) 
+Heap::decFreq (Theap *H, rint id) 
   // dec freq of pair Rec[id]
   { Trecord *rec = H->Rec->records;
-    int freq = rec[id].freq--;
-    int hpos = rec[id].hpos;
+    rint freq = rec[id].freq--;
+    rint hpos = rec[id].hpos;
     Thnode *p;
     Thfreq *f,*sf;
-    int fp,sfp;
+    rint fp,sfp;
 if (PRNH) prnH(H);
     if (freq > H->sqrtu) // high freq part
        { p = &H->freq[hpos];
@@ -280,20 +280,20 @@ if (PRNH) prnH(H);
   }
 
 void 
-Heap::insertHeap (Theap *H, int id)  
+Heap::insertHeap (Theap *H, rint id)  
   // with freq 1
   { Trecord *rec = H->Rec->records;
     rec[id].hpos = ArrayG::insertArray (&H->infreq[1],id);
     rec[id].freq = 1;
   }
 
-int 
+rint 
 Heap::extractMax (Theap *H)
   { 
-    int ret;
+    rint ret;
     Thnode *p;
     Thfreq *f;
-    int fp;
+    rint fp;
 if (PRNH) prnH(H);
     if ((H->max == H->sqrtu) && (H->largest == -1)) H->max--;
     if (H->max < H->sqrtu)
@@ -329,7 +329,7 @@ Heap::purgeHeap (Theap *H)
   // remove elems with freq 1 from heap and hash
   // their freq cannot grow after a repair turn
   { 
-    int id,fst,size,max;
+    rint id,fst,size,max;
     size = H->infreq[1].size;
     fst = H->infreq[1].fst;
     max = H->infreq[1].maxsize;
@@ -342,7 +342,7 @@ Heap::purgeHeap (Theap *H)
   }
 
 void 
-Heap::heapRepos (Theap *H, int id) 
+Heap::heapRepos (Theap *H, rint id) 
   // repositions pair
   { Trecord *rec = H->Rec->records;
     if (rec[id].freq < H->sqrtu) 
@@ -39,26 +39,26 @@ Chile. Blanco Encalada 2120, Santiago, Chile. gnavarro@dcc.uchile.cl
 #include "records.h"
 
 typedef struct 
-  { int freq;
-    int elems; // a pointer within freq array
-    int larger,smaller; // pointers within ff array
+  { rint freq;
+    rint elems; // a pointer within freq array
+    rint larger,smaller; // pointers within ff array
   } Thfreq;
 
 typedef struct 
-  { int id;
-    int prev,next; // actually pointers within freq array
-    int fnode; // ptr to its freq node (ptr to ff)
+  { rint id;
+    rint prev,next; // actually pointers within freq array
+    rint fnode; // ptr to its freq node (ptr to ff)
   } Thnode;
 
 typedef struct
   { Thnode *freq; // space for all frequent nodes is preallocated, sqrt(u)
-    int freef; // ptr to free list in freq
+    rint freef; // ptr to free list in freq
     Thfreq *ff; // space for all frequencies of frequent nodes prealloc idem
-    int freeff; // ptr to free list in ff
-    int smallest,largest; // list of frequent ones (ptrs in ff)
+    rint freeff; // ptr to free list in ff
+    rint smallest,largest; // list of frequent ones (ptrs in ff)
     Tarray *infreq; // vectors for infrequent ones
-    int sqrtu;
-    int max;  // max freq heap used
+    rint sqrtu;
+    rint max;  // max freq heap used
     Trarray *Rec; // records
   } Theap;
 
@@ -68,23 +68,23 @@ public:
 	// creates new empty heap
 	// 0<factor<1: occupancy factor
 	// sqrt(u)*max(minsize,n/factor) integers
-	static Theap createHeap (int u, Trarray *Rec, float factor, int minsize); 
+	static Theap createHeap (rint u, Trarray *Rec, float factor, rint minsize); 
 	// destroys H
 	static void destroyHeap (Theap *H); 
 	// inc freq of pair Rec[id]
-	static void incFreq (Theap *H, int id); 
+	static void incFreq (Theap *H, rint id); 
 	// dec freq of pair Rec[id]
-	static void decFreq (Theap *H, int id); 
+	static void decFreq (Theap *H, rint id); 
 	// with freq 1
-	static void insertHeap (Theap *H, int id);  
+	static void insertHeap (Theap *H, rint id);  
 
-	static int extractMax (Theap *H);
+	static rint extractMax (Theap *H);
 	// remove elems with freq 1
 	static void purgeHeap (Theap *H); 
 	// repositions pair
-	static void heapRepos (Theap *H, int id); 
+	static void heapRepos (Theap *H, rint id); 
 
-	static void move (Tarray A, int i, int j, Trecord *rec);
+	static void move (Tarray A, rint i, rint j, Trecord *rec);
 	static void prnH (Theap *H);
 };
 #endif
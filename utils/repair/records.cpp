@@ -29,9 +29,9 @@ Chile. Blanco Encalada 2120, Santiago, Chile. gnavarro@dcc.uchile.cl
 #include <stdlib.h>
 #include "records.h"
 
-int 
+rint 
 Records::insertRecord (Trarray *Rec, Tpair pair)
-   { int id;
+   { rint id;
      Trecord *rec;
      if (Rec->size == Rec->maxsize)
 	{ if (Rec->maxsize == 0)
@@ -67,7 +67,7 @@ Records::deleteRecord (Trarray *Rec)
    }
 
 Trarray 
-Records::createRecords (float factor, int minsize)
+Records::createRecords (float factor, rint minsize)
    { Trarray Rec;
      Rec.records = NULL;
      Rec.maxsize = 0;
@@ -100,7 +100,7 @@ Records::destroyRecords (Trarray *Rec)
    }
      
 void 
-Records::removeRecord (Trarray *Rec, int id) 
+Records::removeRecord (Trarray *Rec, rint id) 
    // delete record, freq <= 1
    // due to freq 0 or purgue (freq 1)
    // already deleted from heap
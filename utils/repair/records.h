@@ -32,23 +32,23 @@ Chile. Blanco Encalada 2120, Santiago, Chile. gnavarro@dcc.uchile.cl
 #include "basics.h"
 
 typedef struct
-   { int prev,next;
+   { rint prev,next;
    } Tlist; // list of prev next equal char
 
 typedef struct
    { Tpair pair; // pair content
-     int freq; // frequency
-     int cpos; // 1st position in C
-     int hpos; // position in heap
-     int kpos; // position in hash
+     rint freq; // frequency
+     rint cpos; // 1st position in C
+     rint hpos; // position in heap
+     rint kpos; // position in hash
    } Trecord;
 
 typedef struct
    { Trecord *records; 
-     int maxsize;  
-     int size;
+     rint maxsize;  
+     rint size;
      float factor;
-     int minsize;
+     rint minsize;
      void *Hash;  // Thash *
      void *Heap; // Theap *
      void *List; // Tlist *
@@ -63,11 +63,11 @@ class Records
 public:
 	// inserts pair in Rec, returns id, links to/from
 	// Hash and Heap, not List. sets freq = 1
-	static int insertRecord (Trarray *Rec, Tpair pair); 
+	static rint insertRecord (Trarray *Rec, Tpair pair); 
 	// deletes last cell in Rec
 	static void deleteRecord (Trarray *Rec);
 	 // creates empty array
-	static Trarray createRecords (float factor, int minsize);
+	static Trarray createRecords (float factor, rint minsize);
 	// associates structures
 	static void assocRecords (Trarray *Rec, void *Hash, void *Heap, void *List); 
 	// destroys Rec
@@ -75,6 +75,6 @@ public:
 	// delete record, freq <= 1
 	// due to freq 0 or purgue (freq 1)
 	// already deleted from heap
-	static void removeRecord (Trarray *Rec, int id);
+	static void removeRecord (Trarray *Rec, rint id);
 };
 #endif
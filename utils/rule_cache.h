@@ -0,0 +1,63 @@
+#ifndef IMPROVED_GRAMMAR_INDEX_RULE_CACHE_H
+#define IMPROVED_GRAMMAR_INDEX_RULE_CACHE_H
+
+#include <string>
+#include "sharded_lru.h"
+
+/*
+ * Bounded LRU cache of decoded rules. For every rule it keeps at most K symbols
+ * of its expansion (the first K for prefixes or the last K in reverse order for suffixes)
+ * and whether they are the complete expansion of the rule.
+ *
+ * Every rule costs 1 in a sharded_lru, so the cache can be shared by the threads of a query.
+ * */
+class rule_cache {
+
+    public:
+        typedef uint64_t key_type;
+
+        struct entry{
+            std::string s;
+            bool complete{false};
+        };
+
+    protected:
+
+        size_t K{0};
+        sharded_lru<key_type,entry> rules;
+
+    public:
+
+        rule_cache() = default;
+        rule_cache(const size_t & c, const size_t & k){ reset(c,k); }
+        ~rule_cache() = default;
+
+        /*
+         * Empty the cache and set the number of rules (0 disables the cache) and symbols per rule
+         * */
+        void reset(const size_t & c, const size_t & k){
+            K = k;
+            rules.reset(c);
+        }
+
+        /*
+         * Empty the cache keeping its capacity (e.g. when the index loads another grammar)
+         * */
+        void clear(){ rules.clear(); }
+
+        bool enabled() const { return rules.enabled() && K > 0; }
+        size_t length() const { return K; }
+
+        /*
+         * Copy the entry of the rule X in e, return false if X is not in the cache
+         * */
+        bool get(const key_type & X, entry & e){ return rules.get(X,e); }
+
+        void put(const key_type & X, const entry & e){ rules.put(X,e,1); }
+
+        size_t size_in_bytes() const{
+            return sizeof(K) + rules.size_in_bytes([](const entry & e){ return e.s.capacity(); });
+        }
+};
+
+#endif //IMPROVED_GRAMMAR_INDEX_RULE_CACHE_H
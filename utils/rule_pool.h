@@ -0,0 +1,85 @@
+#ifndef IMPROVED_GRAMMAR_INDEX_RULE_POOL_H
+#define IMPROVED_GRAMMAR_INDEX_RULE_POOL_H
+
+#include <string>
+#include <fstream>
+#include <sdsl/int_vector.hpp>
+
+/*
+ * Complete expansions of the short rules concatenated in a single string, the expansion of the
+ * rule X is pool[start[X], start[X+1]) (empty for the rules that are not stored).
+ * */
+class rule_pool {
+
+    protected:
+
+        std::string pool;
+        sdsl::int_vector<> start;
+
+    public:
+
+        rule_pool() = default;
+        ~rule_pool() = default;
+
+        /*
+         * Empty pool for n_rules rules
+         * */
+        void reset(const uint64_t & n_rules){
+            pool.clear();
+            start = sdsl::int_vector<>(n_rules + 1,0,64);
+        }
+
+        void clear(){
+            pool = std::string();
+            start = sdsl::int_vector<>();
+        }
+
+        /*
+         * Store the l symbols of s as the expansion of X (l = 0 to skip it),
+         * it has to be called for X = 1, 2, ... in order
+         * */
+        void append(const uint64_t & X, const char * s, const uint64_t & l){
+            pool.append(s,l);
+            start[X + 1] = pool.size();
+        }
+
+        /*
+         * Compress the offsets once all the rules are set
+         * */
+        void compress(){
+            pool.shrink_to_fit();
+            sdsl::util::bit_compress(start);
+        }
+
+        bool empty() const { return pool.empty(); }
+
+        /*
+         * Length of the stored expansion of X (0 if X is not stored)
+         * */
+        uint64_t length(const uint64_t & X) const {
+            return (X + 1 < start.size())? start[X + 1] - start[X] : 0;
+        }
+
+        const char * data(const uint64_t & X) const { return pool.data() + start[X]; }
+
+        void save(std::fstream & f) const{
+            uint64_t n = pool.size();
+            sdsl::write_member(n,f);
+            f.write(pool.data(),n);
+            sdsl::serialize(start,f);
+        }
+
+        void load(std::fstream & f){
+            uint64_t n = 0;
+            sdsl::read_member(n,f);
+            pool.resize(n);
+            f.read(&pool[0],n);
+            sdsl::load(start,f);
+        }
+
+        size_t size_in_bytes() const{
+            return sizeof(uint64_t) + pool.size() + sdsl::size_in_bytes(start);
+        }
+};
+
+#endif //IMPROVED_GRAMMAR_INDEX_RULE_POOL_H
@@ -0,0 +1,141 @@
+#ifndef IMPROVED_GRAMMAR_INDEX_SHARDED_LRU_H
+#define IMPROVED_GRAMMAR_INDEX_SHARDED_LRU_H
+
+#include <list>
+#include <cstdint>
+#include <mutex>
+#include <atomic>
+#include <vector>
+#include <functional>
+#include <unordered_map>
+
+/*
+ * Bounded LRU map shared by the threads of the queries. Every entry has a cost given by the
+ * caller (1 to bound the number of entries or its size in bytes to bound the memory) and the
+ * least recently used entries are evicted while the total cost exceeds the budget.
+ *
+ * The keys are distributed over several shards (by hash), each one with its own list and mutex,
+ * so concurrent queries only contend when they touch the same shard.
+ * */
+template<typename K, typename V, typename H = std::hash<K>>
+class sharded_lru {
+
+    protected:
+
+        struct item{
+            K key;
+            V value;
+            size_t cost;
+        };
+
+        struct shard{
+            std::list<item> items; // most recently used first
+            std::unordered_map<K, typename std::list<item>::iterator, H> pos;
+            size_t cost{0};
+            std::mutex m;
+        };
+
+        size_t budget{0};
+        std::vector<shard> shards;
+        std::atomic<uint64_t> n_hits{0};
+        std::atomic<uint64_t> n_misses{0};
+
+        shard& get_shard(const K & key){
+            return shards[H()(key) % shards.size()];
+        }
+
+    public:
+
+        sharded_lru() = default;
+        explicit sharded_lru(const size_t & b){ reset(b); }
+        ~sharded_lru() = default;
+
+        /*
+         * The copies do not share the cached entries
+         * */
+        sharded_lru(const sharded_lru & C){ reset(C.budget); }
+        sharded_lru& operator=(const sharded_lru & C){
+            reset(C.budget);
+            return *this;
+        }
+
+        /*
+         * Empty the cache and set its budget (0 disables the cache)
+         * */
+        void reset(const size_t & b){
+            budget = b;
+            shards = std::vector<shard>((b == 0)?0:((b < 16)?1:16));
+            n_hits = 0;
+            n_misses = 0;
+        }
+
+        /*
+         * Empty the cache keeping its budget (e.g. when the index loads another grammar)
+         * */
+        void clear(){ reset(budget); }
+
+        bool enabled() const { return budget > 0; }
+
+        /*
+         * Copy the value of key in v, return false if key is not in the cache
+         * (always false while the cache is disabled)
+         * */
+        bool get(const K & key, V & v){
+            if(shards.empty())
+                return false;
+            auto& sh = get_shard(key);
+            std::lock_guard<std::mutex> lock(sh.m);
+            auto it = sh.pos.find(key);
+            if(it == sh.pos.end())
+            {
+                ++n_misses;
+                return false;
+            }
+            ++n_hits;
+            sh.items.splice(sh.items.begin(),sh.items,it->second);
+            v = it->second->value;
+            return true;
+        }
+
+        /*
+         * Insert key with value v (nothing while the cache is disabled)
+         * */
+        void put(const K & key, const V & v, const size_t & cost){
+            if(shards.empty())
+                return;
+            auto& sh = get_shard(key);
+            size_t sh_budget = budget/shards.size();
+            if(cost > sh_budget)
+                return;
+            std::lock_guard<std::mutex> lock(sh.m);
+            if(sh.pos.find(key) != sh.pos.end())
+                return;
+            sh.items.push_front(item{key,v,cost});
+            sh.pos[key] = sh.items.begin();
+            sh.cost += cost;
+            while(sh.cost > sh_budget)
+            {
+                sh.cost -= sh.items.back().cost;
+                sh.pos.erase(sh.items.back().key);
+                sh.items.pop_back();
+            }
+        }
+
+        uint64_t hits() const { return n_hits; }
+        uint64_t misses() const { return n_misses; }
+
+        /*
+         * Space of the entries, value_bytes(v) gives the memory owned by a value outside the item
+         * (not synchronized with put, call it when no query is running)
+         * */
+        template<typename F>
+        size_t size_in_bytes(const F & value_bytes) const{
+            size_t s = sizeof(sharded_lru);
+            for (auto &&sh : shards)
+                for (auto &&it : sh.items)
+                    s += sizeof(it) + value_bytes(it.value);
+            return s;
+        }
+};
+
+#endif //IMPROVED_GRAMMAR_INDEX_SHARDED_LRU_H
@@ -0,0 +1,133 @@
+#ifndef IMPROVED_GRAMMAR_INDEX_WS_DEQUE_H
+#define IMPROVED_GRAMMAR_INDEX_WS_DEQUE_H
+
+#include <atomic>
+#include <memory>
+#include <vector>
+#include <cstdint>
+#include <utility>
+
+/*
+ * Lock-free work-stealing deque of (node, offset) pairs (Chase-Lev, with the memory orders of
+ * Le et al. "Correct and efficient work-stealing for weak memory models", PPoPP 2013).
+ *
+ * Only the owner thread calls push and pop, working on the bottom; any thread calls steal,
+ * which takes from the top with a CAS. The items are stored in two atomic words, a steal that
+ * reads a slot being overwritten by the owner always fails its CAS, so it never returns a torn
+ * item. The circular buffer doubles when it is full, the old buffers are kept until the deque
+ * is destroyed because a thief may still be reading them.
+ * */
+class ws_deque {
+
+    public:
+        typedef std::pair<size_t, long int> item;
+
+    protected:
+
+        struct slot{
+            std::atomic<uint64_t> node;
+            std::atomic<int64_t> offset;
+        };
+
+        struct buffer{
+            int64_t mask;
+            std::unique_ptr<slot[]> slots;
+
+            explicit buffer(const int64_t & size):mask(size - 1),slots(new slot[size]){}
+
+            int64_t size() const { return mask + 1; }
+
+            void put(const int64_t & i, const item & x){
+                slots[i & mask].node.store(x.first,std::memory_order_relaxed);
+                slots[i & mask].offset.store(x.second,std::memory_order_relaxed);
+            }
+
+            item get(const int64_t & i) const{
+                return item(slots[i & mask].node.load(std::memory_order_relaxed),
+                            slots[i & mask].offset.load(std::memory_order_relaxed));
+            }
+        };
+
+        alignas(64) std::atomic<int64_t> top{0};
+        alignas(64) std::atomic<int64_t> bottom{0};
+        std::atomic<buffer*> array;
+        std::vector<std::unique_ptr<buffer>> buffers; // the current one and the retired ones (owner only)
+
+    public:
+
+        explicit ws_deque(const int64_t & size = 1024){
+            int64_t s = 1;
+            while(s < size) s <<= 1;
+            buffers.emplace_back(new buffer(s));
+            array.store(buffers.back().get(),std::memory_order_relaxed);
+        }
+
+        ws_deque(const ws_deque &) = delete;
+        ws_deque& operator=(const ws_deque &) = delete;
+
+        /*
+         * Owner only
+         * */
+        void push(const item & x){
+            int64_t b = bottom.load(std::memory_order_relaxed);
+            int64_t t = top.load(std::memory_order_acquire);
+            buffer* a = array.load(std::memory_order_relaxed);
+            if(b - t > a->size() - 1)
+            {
+                buffers.emplace_back(new buffer(2*a->size()));
+                buffer* na = buffers.back().get();
+                for (int64_t i = t; i < b; ++i)
+                    na->put(i,a->get(i));
+                array.store(na,std::memory_order_release);
+                a = na;
+            }
+            a->put(b,x);
+            std::atomic_thread_fence(std::memory_order_release);
+            bottom.store(b + 1,std::memory_order_relaxed);
+        }
+
+        /*
+         * Owner only, take the last pushed item, return false if the deque is empty
+         * */
+        bool pop(item & x){
+            int64_t b = bottom.load(std::memory_order_relaxed) - 1;
+            buffer* a = array.load(std::memory_order_relaxed);
+            bottom.store(b,std::memory_order_relaxed);
+            std::atomic_thread_fence(std::memory_order_seq_cst);
+            int64_t t = top.load(std::memory_order_relaxed);
+            bool found = true;
+            if(t <= b)
+            {
+                x = a->get(b);
+                if(t == b)
+                {
+                    // last item, race with the thieves
+                    if(!top.compare_exchange_strong(t,t + 1,std::memory_order_seq_cst,std::memory_order_relaxed))
+                        found = false;
+                    bottom.store(b + 1,std::memory_order_relaxed);
+                }
+            }
+            else
+            {
+                found = false;
+                bottom.store(b + 1,std::memory_order_relaxed);
+            }
+            return found;
+        }
+
+        /*
+         * Any thread, take the oldest item, return false if the deque is empty or another thread won it
+         * */
+        bool steal(item & x){
+            int64_t t = top.load(std::memory_order_acquire);
+            std::atomic_thread_fence(std::memory_order_seq_cst);
+            int64_t b = bottom.load(std::memory_order_acquire);
+            if(t >= b)
+                return false;
+            buffer* a = array.load(std::memory_order_acquire);
+            x = a->get(t);
+            return top.compare_exchange_strong(t,t + 1,std::memory_order_seq_cst,std::memory_order_relaxed);
+        }
+};
+
+#endif //IMPROVED_GRAMMAR_INDEX_WS_DEQUE_H